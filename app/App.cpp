@@ -46,6 +46,8 @@ int App::run(int argc, char* argv[]) {
     std::cout << "Config file: " << args[0] << std::endl;
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+    // sendfile() has no MSG_NOSIGNAL: a client hanging up mid-file must not kill the server
+    signal(SIGPIPE, SIG_IGN);
 
     // Build servers via config source and start
     Servers servers;
@@ -0,0 +1,126 @@
+// Microbenchmark for the byte scanning kernels (make bench).
+// Splits realistic 1-8KB request heads the way RequestParser does: find each
+// '\n', find the ':' of the line, lowercase the header name. Prints bytes per
+// cycle (TSC) for every kernel this CPU supports.
+#include "../utils/ByteScan.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>
+static uint64_t ticks() { return __rdtsc(); }
+static const char *tickUnit = "cycle";
+#else
+static uint64_t ticks()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+static const char *tickUnit = "ns";
+#endif
+
+// A browser-like request grown to `size` with cookie and tracing headers
+static std::string makeHead(size_t size)
+{
+    std::string head =
+        "GET /static/app/bundle.3f9a1c.js?v=20240611 HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/126.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+        "Accept-Language: en-US,en;q=0.9,fr;q=0.8\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Referer: https://www.example.com/products/catalog?page=3&sort=price\r\n"
+        "Connection: keep-alive\r\n"
+        "Sec-Fetch-Dest: script\r\n"
+        "Sec-Fetch-Mode: no-cors\r\n"
+        "Sec-Fetch-Site: same-origin\r\n";
+    int n = 0;
+    while (head.size() + 4 < size)
+    {
+        std::string line = (n % 3 == 0) ? "Cookie: session=" : (n % 3 == 1) ? "X-Request-Trace-Id: " : "If-None-Match: W/\"";
+        for (int i = 0; i < 40 + (n * 37) % 160; ++i)
+            line += (char)('a' + (i * 7 + n) % 26);
+        line += "\r\n";
+        if (head.size() + line.size() + 2 > size)
+            break;
+        head += line;
+        n++;
+    }
+    head += "\r\n";
+    return head;
+}
+
+// What the parser does with a head, reduced to the scanning work
+static size_t splitHead(const ByteScanKernels &k, const std::string &head, char *name)
+{
+    const char *p = head.data();
+    const char *end = p + head.size();
+    size_t headers = 0;
+    while (p < end)
+    {
+        const char *nl = k.findByte(p, '\n', end - p);
+        if (!nl)
+            break;
+        const char *colon = k.findByte(p, ':', nl - p);
+        if (colon)
+        {
+            size_t len = colon - p;
+            for (size_t i = 0; i < len; ++i)
+                name[i] = p[i];
+            k.toLower(name, len);
+            headers++;
+        }
+        p = nl + 1;
+    }
+    return headers;
+}
+
+int main()
+{
+    size_t count;
+    const ByteScanKernels *kernels = byteScanKernels(count);
+    static const size_t sizes[] = { 1024, 2048, 4096, 8192 };
+    char name[8192];
+    volatile size_t sink = 0;
+
+    std::cout << "bytes/" << tickUnit << " (higher is better), active kernel: "
+              << kernels[count - 1].name << std::endl;
+    std::cout << std::setw(8) << "head";
+    for (size_t k = 0; k < count; ++k)
+        std::cout << std::setw(10) << kernels[k].name;
+    std::cout << std::setw(10) << "speedup" << std::endl;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        std::string head = makeHead(sizes[s]);
+        const int rounds = (int)(64 * 1024 * 1024 / head.size());
+        std::vector<double> rate(count);
+        for (size_t k = 0; k < count; ++k)
+        {
+            // Best of a few runs, to keep scheduler noise out
+            double best = 0;
+            for (int run = 0; run < 5; ++run)
+            {
+                uint64_t start = ticks();
+                for (int r = 0; r < rounds; ++r)
+                    sink += splitHead(kernels[k], head, name);
+                uint64_t spent = ticks() - start;
+                double bytes = (double)head.size() * rounds / (double)(spent ? spent : 1);
+                if (bytes > best)
+                    best = bytes;
+            }
+            rate[k] = best;
+        }
+        std::cout << std::setw(8) << head.size() << std::fixed << std::setprecision(2);
+        for (size_t k = 0; k < count; ++k)
+            std::cout << std::setw(10) << rate[k];
+        std::cout << std::setw(9) << rate[count - 1] / rate[0] << "x" << std::endl;
+    }
+    (void)sink;
+    return 0;
+}
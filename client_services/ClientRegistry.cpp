@@ -1,56 +1,97 @@
 #include "ClientRegistry.hpp"
 #include "../logging/Logger.hpp"
 #include <sstream>
-#include <map>
 
-std::vector<int> g_active_clients;
-std::map<int, int> g_client_server_map; // client_fd -> server_num
+ClientRegistry::ClientRegistry() : workerId(0) {}
 
-void addClient(int client_sock, int server_num) {
-    g_active_clients.push_back(client_sock);
-    g_client_server_map[client_sock] = server_num;
+ClientRegistry::~ClientRegistry() {
+    for (size_t i = 0; i < slab.size(); ++i)
+        delete slab[i];
+}
+
+void ClientRegistry::setWorkerId(int id) {
+    workerId = id;
+}
+
+Connection &ClientRegistry::addClient(int client_sock, int listener, int server_index) {
+    size_t fd = (size_t)client_sock;
+    if (fd >= slab.size()) {
+        size_t size = slab.empty() ? 1024 : slab.size();
+        while (size <= fd)
+            size *= 2;
+        slab.resize(size, NULL);
+        open.resize(size, false);
+    }
+    if (!slab[fd])
+        slab[fd] = new Connection();
+
+    Connection &conn = *slab[fd];
+    conn.reset(client_sock, listener, server_index);
+    conn.activeSlot = active_clients.size();
+    open[fd] = true;
+    active_clients.push_back(client_sock);
+    if ((size_t)listener >= per_listener.size())
+        per_listener.resize(listener + 1, 0);
+    per_listener[listener]++;
     {
         std::ostringstream oss;
         oss << "Client connected (fd=" << client_sock
-            << ") on Server " << server_num
-            << ". Active clients: " << g_active_clients.size();
+            << ") on Server " << server_index + 1
+            << " [worker " << workerId << "]"
+            << ". Active clients: " << active_clients.size();
         Logger::info(oss.str());
     }
+    return conn;
 }
 
-void removeClient(int client_sock) {
-    for (std::vector<int>::iterator it = g_active_clients.begin();
-         it != g_active_clients.end(); ++it) {
-        if (*it == client_sock) {
-            g_active_clients.erase(it);
-            break;
-        }
-    }
-    
-    int server_num = 0;
-    std::map<int, int>::iterator it = g_client_server_map.find(client_sock);
-    if (it != g_client_server_map.end()) {
-        server_num = it->second;
-        g_client_server_map.erase(it);
-    }
-    
+void ClientRegistry::removeClient(int client_sock) {
+    Connection *conn = find(client_sock);
+    if (!conn)
+        return;
+
+    // Swap-remove keeps the active list dense without a search
+    int last = active_clients.back();
+    active_clients[conn->activeSlot] = last;
+    slab[last]->activeSlot = conn->activeSlot;
+    active_clients.pop_back();
+    open[client_sock] = false;
+    per_listener[conn->listener]--;
+    conn->recvBuf.clear();
+    conn->recvBuf.release(buffers);
+    // Files still queued and the splice pipe are descriptors too: give them back now
+    conn->sendQueue.clear();
+    conn->closePipe();
+
     {
         std::ostringstream oss;
-        oss << "Client disconnected (fd=" << client_sock;
-        if (server_num > 0) {
-            oss << ") from Server " << server_num;
-        } else {
-            oss << ")";
-        }
-        oss << ". Active clients: " << g_active_clients.size();
+        oss << "Client disconnected (fd=" << client_sock
+            << ") from Server " << conn->serverIndex + 1
+            << " [worker " << workerId << "]"
+            << ". Active clients: " << active_clients.size();
         Logger::info(oss.str());
     }
 }
 
-int getClientServer(int client_sock) {
-    std::map<int, int>::iterator it = g_client_server_map.find(client_sock);
-    if (it != g_client_server_map.end()) {
-        return it->second;
-    }
-    return 0; // Not found
+Connection *ClientRegistry::find(int client_sock) {
+    if (client_sock < 0 || (size_t)client_sock >= open.size() || !open[client_sock])
+        return NULL;
+    return slab[client_sock];
+}
+
+size_t ClientRegistry::count() const {
+    return active_clients.size();
+}
+
+size_t ClientRegistry::countFor(int listener) const {
+    if (listener < 0 || (size_t)listener >= per_listener.size())
+        return 0;
+    return per_listener[listener];
+}
+
+const std::vector<int> &ClientRegistry::activeClients() const {
+    return active_clients;
+}
+
+BufferPool &ClientRegistry::bufferPool() {
+    return buffers;
 }
@@ -2,11 +2,34 @@
 #define CLIENT_REGISTRY_HPP
 
 #include <vector>
+#include "Connection.hpp"
 
-extern std::vector<int> g_active_clients;
+// Tracks the clients of one worker; never shared between threads.
+// Connections sit in a slab indexed by fd, so a lookup is one array access.
+class ClientRegistry {
+public:
+    ClientRegistry();
+    ~ClientRegistry();
 
-void addClient(int client_sock, int server_num);
-void removeClient(int client_sock);
-int getClientServer(int client_sock);
+    void setWorkerId(int id);
+    Connection &addClient(int client_sock, int listener, int server_index);
+    void removeClient(int client_sock);
+    Connection *find(int client_sock);
+    size_t count() const;
+    size_t countFor(int listener) const;
+    const std::vector<int> &activeClients() const;
+    BufferPool &bufferPool();
 
-#endif
\ No newline at end of file
+private:
+    int workerId;
+    std::vector<Connection *> slab;  // fd -> connection, NULL slots were never used
+    std::vector<bool> open;          // fd -> slot currently holds a live connection
+    std::vector<int> active_clients;
+    std::vector<size_t> per_listener; // listener index -> open connections
+    BufferPool buffers;              // receive blocks of this worker's connections
+
+    ClientRegistry(const ClientRegistry &);
+    ClientRegistry &operator=(const ClientRegistry &);
+};
+
+#endif
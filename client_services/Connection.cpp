@@ -0,0 +1,49 @@
+#include "Connection.hpp"
+#include <unistd.h>
+
+Connection::Connection()
+    : fd(-1), listener(0), serverIndex(0), activeSlot(0), requestCount(0),
+      keepAlive(true), writeArmed(false), closePending(false), parsePaused(false), readPaused(false),
+      timerPhase(0), location(0), headOnly(false), cgiRunning(0),
+      tag(0), pending(0), recvArmed(false), sending(false), closeQueued(false), spliced(0) {
+    splicePipe[0] = -1;
+    splicePipe[1] = -1;
+}
+
+// Makes the record describe a freshly accepted client. Queues and the parser
+// start empty; the receive block already went back to the pool when the
+// previous client left.
+void Connection::reset(int clientFd, int listenerIndex, int server) {
+    fd = clientFd;
+    listener = listenerIndex;
+    serverIndex = server;
+    requestCount = 0;
+    keepAlive = true;
+    writeArmed = false;
+    closePending = false;
+    parsePaused = false;
+    readPaused = false;
+    timerPhase = 0;
+    location = 0;
+    headOnly = false;
+    cgiRunning = 0;
+    tag = 0;
+    pending = 0;
+    recvArmed = false;
+    sending = false;
+    closeQueued = false;
+    spliced = 0;
+    parser.reset();
+    recvBuf.clear();
+    sendQueue.clear();
+}
+
+// The pipe is only created for clients that were sent a file over io_uring
+void Connection::closePipe() {
+    for (int i = 0; i < 2; ++i) {
+        if (splicePipe[i] >= 0)
+            close(splicePipe[i]);
+        splicePipe[i] = -1;
+    }
+    spliced = 0;
+}
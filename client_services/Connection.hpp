@@ -0,0 +1,58 @@
+#ifndef CONNECTION_HPP
+#define CONNECTION_HPP
+
+#include <string>
+#include <ctime>
+#include <sys/socket.h>
+#include "../utils/TimerWheel.hpp"
+#include "../utils/RecvBuffer.hpp"
+#include "../utils/SendQueue.hpp"
+#include "../http/RequestParser.hpp"
+
+struct Location;
+
+// Everything the event loop knows about one client socket.
+// Records live in the ClientRegistry slab (indexed by fd) and are recycled
+// when the fd number is handed out again, so their buffers keep their capacity.
+struct Connection
+{
+    int fd;
+    int listener;         // accepting socket, index into servers.vhosts.addresses()
+    int serverIndex;      // virtual host answering it, index into servers.servers: the
+                          // listener's default server until a Host header names another
+    size_t activeSlot;    // position in ClientRegistry::activeClients()
+
+    RecvBuffer recvBuf;   // bytes received but not consumed by the parser yet
+    RequestParser parser; // request being received, resumes on every read
+    SendQueue sendQueue;  // response bytes waiting for the socket
+    int requestCount;     // requests served on this connection
+
+    bool keepAlive;       // false once the response in flight is the last one
+    bool writeArmed;      // registered for write readiness (epoll/select)
+    bool closePending;    // queued for closing at the end of the event batch
+    bool parsePaused;     // pipelined requests wait in recvBuf until sendQueue drains
+    bool readPaused;      // no reads meanwhile: read interest dropped, or no RECV armed
+
+    TimerNode timer;      // the one deadline currently running for this connection
+    int timerPhase;       // what `timer` is waiting for (see ServerMain.cpp)
+    const Location *location; // route of the last request, for its timeouts
+    bool headOnly;        // the last request is a HEAD: its responses go without a body
+    int cgiRunning;       // CGI scripts producing a response for this connection
+
+    // io_uring engine
+    unsigned tag;          // generation tag carried in every user_data of this connection
+    int pending;           // requests in flight; the record is released when this drops to 0 after close
+    bool recvArmed;        // a multishot RECV is in flight
+    bool sending;          // a SENDMSG (or SPLICE) of the front of `sendQueue` is in flight
+    bool closeQueued;      // a CLOSE has been submitted
+    struct iovec sendIov[SendQueue::BATCH]; // read by the kernel until the send completes
+    struct msghdr sendMsg;
+    int splicePipe[2];     // file bytes go through this pipe on their way to the socket
+    size_t spliced;        // bytes of the front file segment sitting in the pipe
+
+    Connection();
+    void reset(int clientFd, int listenerIndex, int server);
+    void closePipe();
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "ErrorPages.hpp"
+#include "HttpUtils.hpp"
+#include <fstream>
+#include <sstream>
+
+// Codes the server sends itself, rendered up front
+static const int BUILTIN_CODES[] = {400, 403, 404, 405, 408, 411, 413, 414, 416, 431, 500, 501, 503, 505, 508, 0};
+
+static std::string pageFile(const Server &server, std::string path)
+{
+    if (path.empty() || path[0] != '/')
+        path = "/" + path;
+    std::string root = server.root;
+    if (root.empty())
+        return path;
+    if (root[root.size() - 1] == '/')
+        root.erase(root.size() - 1);
+    return root + path;
+}
+
+void ErrorPages::load(const Servers &servers)
+{
+    for (size_t i = 0; BUILTIN_CODES[i]; ++i)
+        builtinPage(BUILTIN_CODES[i]);
+    for (size_t s = 0; s < servers.servers.size(); ++s)
+    {
+        const Server &server = servers.servers[s];
+        Table &table = custom[&server];
+        std::map<int, std::string>::const_iterator it;
+        for (it = server.error_pages.begin(); it != server.error_pages.end(); ++it)
+        {
+            Page &page = table[it->first];
+            page.file = pageFile(server, it->second);
+            page.ino = 0;
+            page.size = -1;
+            page.mtime.tv_sec = 0;
+            page.mtime.tv_nsec = 0;
+            struct stat st;
+            if (::stat(page.file.c_str(), &st) == 0)
+                render(page, it->first, st);
+            builtinPage(it->first);
+        }
+    }
+}
+
+const std::string &ErrorPages::builtinPage(int code)
+{
+    std::map<int, std::string>::iterator it = builtin.find(code);
+    if (it == builtin.end())
+        it = builtin.insert(std::make_pair(code, buildErrorResponse(code, statusReason(code)))).first;
+    return it->second;
+}
+
+bool ErrorPages::render(Page &page, int code, const struct stat &st)
+{
+    page.ino = st.st_ino;
+    page.size = st.st_size;
+    page.mtime = st.st_mtim;
+    page.response.clear();
+    // Binary mode: the file goes out byte for byte
+    std::ifstream f(page.file.c_str(), std::ios::binary);
+    if (!f)
+        return false;
+    std::string body((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    std::ostringstream resp;
+    resp << "HTTP/1.1 " << code << " " << statusReason(code) << "\r\n"
+         << "Content-Type: text/html\r\n"
+         << "Content-Length: " << body.size() << "\r\n"
+         << "Connection: close\r\n\r\n"
+         << body;
+    page.response = resp.str();
+    return true;
+}
+
+const std::string &ErrorPages::get(const Server &server, int code, StatCache &stats)
+{
+    std::map<const Server *, Table>::iterator table = custom.find(&server);
+    if (table == custom.end())
+        return builtinPage(code);
+    Table::iterator it = table->second.find(code);
+    if (it == table->second.end())
+        return builtinPage(code);
+
+    Page &page = it->second;
+    struct stat st;
+    if (stats.stat(page.file, st) != 0)
+        return builtinPage(code);
+    if (st.st_ino != page.ino || st.st_size != page.size || st.st_mtim.tv_sec != page.mtime.tv_sec ||
+        st.st_mtim.tv_nsec != page.mtime.tv_nsec)
+        render(page, code, st);
+    if (page.response.empty())
+        return builtinPage(code);
+    return page.response;
+}
@@ -0,0 +1,42 @@
+#ifndef ERROR_PAGES_HPP
+#define ERROR_PAGES_HPP
+
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include "../parsing_validation/ConfigStructs.hpp"
+#include "../utils/StatCache.hpp"
+
+// Complete error responses (status line, headers and body), one store per
+// worker. The built-in pages and the error_page files of every server are
+// rendered once when the worker starts; a request only copies the bytes.
+// A page file edited on disk is read again the next time it is sent: the
+// stat cache tells whether it changed, so an unchanged file costs no syscall.
+class ErrorPages
+{
+public:
+    void load(const Servers &servers);
+
+    // Response for code on server: its error_page file when it has one that
+    // can be read, the built-in page otherwise
+    const std::string &get(const Server &server, int code, StatCache &stats);
+
+private:
+    struct Page
+    {
+        std::string file; // error_page resolved against the server root
+        std::string response; // empty while the file cannot be read
+        ino_t ino;
+        off_t size;
+        struct timespec mtime;
+    };
+    typedef std::map<int, Page> Table;
+
+    std::map<int, std::string> builtin;
+    std::map<const Server *, Table> custom;
+
+    const std::string &builtinPage(int code);
+    bool render(Page &page, int code, const struct stat &st);
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <cctype>
 #include <sstream>
+#include <algorithm>
 
 std::string intToString(int n) {
     std::ostringstream oss;
@@ -13,97 +14,52 @@ std::string intToString(int n) {
     return oss.str();
 }
 
-size_t getRequestLength(const char *buffer, size_t length) 
+const char *statusReason(int code)
 {
-    if (length < 4)
-    {
-        return 0;
-    }
-    //for windows
-    long headers_end = -1;
-    for (size_t i = 0; i + 3 < length; ++i) {
-        if (buffer[i] == '\r' && buffer[i + 1] == '\n' &&
-            buffer[i + 2] == '\r' && buffer[i + 3] == '\n') 
-        {
-            headers_end = (long)(i + 4);
-            break;
-        }
-    }
-    if (headers_end == -1)
-    {
-        return 0; // headers not complete yet
-    }
-
-    // Parse headers to determine body expectations
-    // Optimization: Only construct string for headers to avoid copying large body
-    std::string headerStr(buffer, headers_end);
-    std::map<std::string, std::string> headers = parseHeaders(headerStr);
-
-    // Check for Transfer-Encoding: chunked
-    std::map<std::string, std::string>::iterator it = headers.find("transfer-encoding");
-    if (it != headers.end()) 
-    {
-        std::string te = it->second;
-        for (size_t i = 0; i < te.size(); ++i)
-            te[i] = ft_tolower(te[i]);
-        if (te.find("chunked") != std::string::npos) 
-        {
-            // Check if the zero chunk is right at the beginning of the body (empty body case)
-            if (length >= (size_t)headers_end + 5 && ft_strncmp(buffer + headers_end, "0\r\n\r\n", 5) == 0)
-            {
-                return (size_t)headers_end + 5;
-            }
-            // Lenient check for LF only
-            if (length >= (size_t)headers_end + 4 && ft_strncmp(buffer + headers_end, "0\n\n", 4) == 0)
-            {
-                return (size_t)headers_end + 4;
-            }
-
-            // For chunked, request complete when we see \r\n0\r\n\r\n after headers
-            // We need to search in the body part
-            std::string bodyPart(buffer + headers_end, length - headers_end);
-            const std::string terminator = "\r\n0\r\n\r\n";
-            size_t termPos = bodyPart.find(terminator);
-            if (termPos != std::string::npos)
-            {
-                return headers_end + termPos + terminator.size();
-            }
-            // Some clients might send final chunk with LF only (rare) -> be lenient
-            termPos = bodyPart.find("\n0\n\n");
-            if (termPos != std::string::npos)
-                return headers_end + termPos + 5; // \n0\n\n is 5 chars
-            return 0;
-        }
-    }
-
-    // Otherwise, rely on Content-Length if present, else no body
-    it = headers.find("content-length");
-    if (it != headers.end()) {
-        long bodyLen = 0;
-        std::istringstream iss(it->second);
-        iss >> bodyLen;
-        if (bodyLen < 0)
-            bodyLen = 0;
-        size_t total_needed = (size_t)headers_end + (size_t)bodyLen;
-        if (length >= total_needed)
-            return total_needed;
-        return 0;
+    switch (code) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 303: return "See Other";
+    case 304: return "Not Modified";
+    case 307: return "Temporary Redirect";
+    case 308: return "Permanent Redirect";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 406: return "Not Acceptable";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 410: return "Gone";
+    case 411: return "Length Required";
+    case 412: return "Precondition Failed";
+    case 413: return "Payload Too Large";
+    case 414: return "URI Too Long";
+    case 415: return "Unsupported Media Type";
+    case 416: return "Range Not Satisfiable";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    case 505: return "HTTP Version Not Supported";
+    case 507: return "Insufficient Storage";
+    case 508: return "Loop Detected";
+    default:  return "Error";
     }
-    // No Content-Length and no chunked: assume no body (e.g., GET without body)
-    return (size_t)headers_end;
 }
 
 std::string buildErrorResponse(int code, const std::string &message) 
 {
-    std::string status;
-    switch (code) {
-    case 400: status = "Bad Request"; break;
-    case 404: status = "Not Found"; break;
-    case 405: status = "Method Not Allowed"; break;
-    case 500: status = "Internal Server Error"; break;
-    case 501: status = "Not Implemented"; break;
-    default:  status = "Error"; break;
-    }
+    std::string status = statusReason(code);
 
     std::string body = "<!DOCTYPE html>\n<html>\n<head><title>" +
                        intToString(code) + " " + status +
@@ -121,54 +77,170 @@ std::string buildErrorResponse(int code, const std::string &message)
     return resp.str();
 }
 
-std::map<std::string, std::string> parseHeaders(const std::string &request) {
-    std::map<std::string, std::string> headers;
-    std::istringstream stream(request);
-    std::string line;
-    ft_getline(stream, line); //This reads up to the first newline character (\n) in the stream  but does not include the '\n' in the resulting string.
-    while (ft_getline(stream, line)) {
-        if (!line.empty() && line[line.size() - 1] == '\r')
-            line.erase(line.size() - 1);
-        if (line.empty())
-            break;
-        size_t colon = line.find(':');
-        if (colon != std::string::npos) {
-            std::string key = ft_substr(line, 0, colon);
-            std::string value = ft_substr(line, colon + 1);
-            size_t start = value.find_first_not_of(" \t");
-            if (start != std::string::npos)
-                value = ft_substr(value, start);
-            for (size_t i = 0; i < key.size(); ++i)
-                key[i] = ft_tolower(key[i]);
-            headers[key] = value;
+std::string makeETag(const struct stat &st)
+{
+    std::ostringstream oss;
+    oss << '"' << std::hex << (unsigned long)st.st_mtime << '-' << (unsigned long)st.st_size << '"';
+    return oss.str();
+}
+
+std::string httpDate(time_t t)
+{
+    struct tm tm;
+    char buf[64];
+    gmtime_r(&t, &tm);
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+bool parseHttpDate(const std::string &value, time_t &t)
+{
+    struct tm tm;
+    std::memset(&tm, 0, sizeof(tm));
+    const char *end = strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (!end || *end != '\0')
+        return false;
+    t = timegm(&tm);
+    return true;
+}
+
+bool etagMatches(const std::string &ifNoneMatch, const std::string &etag)
+{
+    size_t pos = 0;
+    while (pos < ifNoneMatch.size())
+    {
+        size_t comma = ifNoneMatch.find(',', pos);
+        if (comma == std::string::npos)
+            comma = ifNoneMatch.size();
+        size_t start = ifNoneMatch.find_first_not_of(" \t", pos);
+        if (start < comma)
+        {
+            size_t stop = ifNoneMatch.find_last_not_of(" \t", comma - 1);
+            std::string tag = ifNoneMatch.substr(start, stop - start + 1);
+            if (tag.compare(0, 2, "W/") == 0)
+                tag = tag.substr(2);
+            if (tag == "*" || tag == etag)
+                return true;
+        }
+        pos = comma + 1;
+    }
+    return false;
+}
+
+bool acceptsEncoding(const std::string &acceptEncoding, const std::string &coding)
+{
+    int named = -1;    // verdict of an element naming coding, -1 when there is none
+    int wildcard = -1; // verdict of "*"
+    size_t pos = 0;
+    while (pos < acceptEncoding.size())
+    {
+        size_t comma = acceptEncoding.find(',', pos);
+        if (comma == std::string::npos)
+            comma = acceptEncoding.size();
+        std::string element = acceptEncoding.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        size_t semi = element.find(';');
+        std::string name = trim(element.substr(0, semi));
+        bool accepted = true;
+        if (semi != std::string::npos)
+        {
+            std::string param = trim(element.substr(semi + 1));
+            if (param.size() > 2 && ft_tolower(param[0]) == 'q' && param[1] == '=')
+                accepted = std::strtod(param.c_str() + 2, NULL) > 0;
         }
+        for (size_t i = 0; i < name.size(); ++i)
+            name[i] = ft_tolower(name[i]);
+        if (name == coding)
+            named = accepted;
+        else if (name == "*")
+            wildcard = accepted;
     }
-    return headers;
+    return named >= 0 ? named == 1 : wildcard == 1;
 }
 
-std::string unchunkBody(const std::string &body)
+// Digits of a range bound; false when there are none or too many to fit in off_t
+static bool parseOffset(const std::string &text, off_t &value)
 {
-    std::string decoded;
-    size_t i = 0;
-    while (i < body.size())
+    if (text.empty() || text.size() > 18)
+        return false;
+    value = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (!ft_isdigit(text[i]))
+            return false;
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+static bool rangeBefore(const ByteRange &a, const ByteRange &b)
+{
+    return a.first < b.first;
+}
+
+bool parseByteRanges(const std::string &value, off_t size, size_t maxRanges, std::vector<ByteRange> &ranges)
+{
+    ranges.clear();
+    if (value.compare(0, 6, "bytes=") != 0)
+        return false;
+    size_t pos = 6;
+    size_t specs = 0;
+    while (pos <= value.size())
+    {
+        size_t comma = value.find(',', pos);
+        if (comma == std::string::npos)
+            comma = value.size();
+        size_t start = value.find_first_not_of(" \t", pos);
+        pos = comma + 1;
+        if (start >= comma)
+            continue; // empty list element
+        size_t stop = value.find_last_not_of(" \t", comma - 1);
+        std::string spec = value.substr(start, stop - start + 1);
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos || ++specs > maxRanges)
+            return false;
+
+        ByteRange range;
+        off_t first;
+        off_t last;
+        if (dash == 0)
+        {
+            // Suffix: the last N bytes
+            if (!parseOffset(spec.substr(1), last))
+                return false;
+            if (last == 0 || size == 0)
+                continue;
+            range.first = last < size ? size - last : 0;
+            range.last = size - 1;
+        }
+        else
+        {
+            if (!parseOffset(spec.substr(0, dash), first))
+                return false;
+            if (dash + 1 == spec.size())
+                last = size - 1;
+            else if (!parseOffset(spec.substr(dash + 1), last) || last < first)
+                return false;
+            if (first >= size)
+                continue;
+            range.first = first;
+            range.last = last < size ? last : size - 1;
+        }
+        ranges.push_back(range);
+    }
+
+    // Overlapping and adjacent ranges are merged, as RFC 9110 allows:
+    // "bytes=0-,0-,..." must not send the whole body once per range
+    std::sort(ranges.begin(), ranges.end(), rangeBefore);
+    size_t kept = 0;
+    for (size_t i = 0; i < ranges.size(); ++i)
     {
-        size_t crlf = body.find("\r\n", i);
-        if (crlf == std::string::npos)
-            break;
-        
-        std::string hexLen = ft_substr(body, i, crlf - i);
-        char *end;
-        long len = ft_strtol(hexLen.c_str(), &end, 16);
-        
-        if (len == 0)
-            break; // Last chunk
-
-        i = crlf + 2;
-        if (i + len > body.size())
-            break; // Malformed or incomplete
-
-        decoded.append(ft_substr(body, i, len));
-        i += len + 2; // Skip data + CRLF
+        if (kept > 0 && ranges[i].first <= ranges[kept - 1].last + 1)
+            ranges[kept - 1].last = std::max(ranges[kept - 1].last, ranges[i].last);
+        else
+            ranges[kept++] = ranges[i];
     }
-    return decoded;
+    ranges.resize(kept);
+    return specs > 0;
 }
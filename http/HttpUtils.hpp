@@ -5,11 +5,41 @@
 #include <map>
 #include <string>
 #include <cstring>
+#include <ctime>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <vector>
 
 std::string intToString(int n);
-size_t getRequestLength(const char *buffer, size_t length);
+// Reason phrase of a status code for the status line, "Error" when unknown
+const char *statusReason(int code);
 std::string buildErrorResponse(int code, const std::string &message);
-std::map<std::string, std::string> parseHeaders(const std::string &request);
-std::string unchunkBody(const std::string &body);
+
+// Validators of a static file, taken from its metadata: the ETag is the quoted
+// mtime and size in hex (as nginx does), dates are IMF-fixdate in GMT
+std::string makeETag(const struct stat &st);
+std::string httpDate(time_t t);
+// False when value is not an IMF-fixdate
+bool parseHttpDate(const std::string &value, time_t &t);
+// True when an If-None-Match value lists etag (weakly compared) or is "*"
+bool etagMatches(const std::string &ifNoneMatch, const std::string &etag);
+
+// True when an Accept-Encoding value accepts coding (named or through "*")
+// with a non-zero q value
+bool acceptsEncoding(const std::string &acceptEncoding, const std::string &coding);
+
+// Inclusive byte range of a representation
+struct ByteRange
+{
+    off_t first;
+    off_t last;
+};
+
+// Parses a Range header value ("bytes=0-99,-500,1000-") against a body of
+// `size` bytes, keeping the satisfiable ranges clipped to it (possibly none:
+// 416), in ascending order with overlapping or adjacent ones merged. False
+// when the header is malformed or asks for more than `maxRanges` ranges: it
+// is then ignored and the whole body is sent.
+bool parseByteRanges(const std::string &value, off_t size, size_t maxRanges, std::vector<ByteRange> &ranges);
 
 #endif // HTTP_UTILS_HPP
@@ -0,0 +1,337 @@
+#include "RequestParser.hpp"
+#include "../utils/Utils.hpp"
+#include "../utils/ByteScan.hpp"
+
+HttpRequest::HttpRequest() : raw(0), contentLength(-1), chunked(false), keepAlive(true) {}
+
+// Strings and the header table keep their capacity, so a connection stops
+// allocating once it has seen its first few requests
+void HttpRequest::clear()
+{
+    method.clear();
+    target.clear();
+    path.clear();
+    query.clear();
+    version.clear();
+    headers.clear();
+    // A huge upload should not stay allocated for the rest of the connection
+    if (body.capacity() > 65536)
+        std::string().swap(body);
+    body.clear();
+    contentLength = -1;
+    chunked = false;
+    keepAlive = true;
+}
+
+static bool sameIgnoreCase(const char *a, const char *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (ft_tolower((unsigned char)a[i]) != ft_tolower((unsigned char)b[i]))
+            return false;
+    }
+    return true;
+}
+
+const HeaderSlice *HttpRequest::header(const char *name) const
+{
+    size_t len = ft_strlen(name);
+    for (size_t i = headers.size(); i-- > 0;)
+    {
+        const HeaderSlice &h = headers[i];
+        if (h.nameLen == len && ft_strncmp(data(h.name), name, len) == 0)
+            return &h;
+    }
+    return 0;
+}
+
+bool HttpRequest::headerIs(const char *name, const char *value) const
+{
+    const HeaderSlice *h = header(name);
+    size_t len = ft_strlen(value);
+    return h && h->valueLen == len && sameIgnoreCase(data(h->value), value, len);
+}
+
+bool HttpRequest::headerHas(const char *name, const char *token) const
+{
+    const HeaderSlice *h = header(name);
+    size_t len = ft_strlen(token);
+    if (!h || len > h->valueLen)
+        return false;
+    const char *v = data(h->value);
+    for (size_t i = 0; i + len <= h->valueLen; ++i)
+    {
+        if (sameIgnoreCase(v + i, token, len))
+            return true;
+    }
+    return false;
+}
+
+RequestParser::RequestParser()
+    : st(REQUEST_LINE), headLen(0), scanned(0), remaining(0), errorCode(0) {}
+
+void RequestParser::reset()
+{
+    st = REQUEST_LINE;
+    req.clear();
+    headLen = 0;
+    scanned = 0;
+    remaining = 0;
+    errorCode = 0;
+}
+
+RequestParser::State RequestParser::state() const
+{
+    return st;
+}
+
+bool RequestParser::started() const
+{
+    return st != REQUEST_LINE && st != COMPLETE;
+}
+
+bool RequestParser::headComplete() const
+{
+    return st != REQUEST_LINE && st != HEADERS && st != FAILED;
+}
+
+int RequestParser::error() const
+{
+    return errorCode;
+}
+
+const HttpRequest &RequestParser::request() const
+{
+    return req;
+}
+
+HttpRequest &RequestParser::request()
+{
+    return req;
+}
+
+void RequestParser::fail(int code)
+{
+    st = FAILED;
+    errorCode = code;
+}
+
+// Finds the next complete line starting at pos: [start, start + len) without
+// its terminator. The search resumes after the bytes scanned by the previous call.
+bool RequestParser::nextLine(const RecvBuffer &buf, size_t &pos, size_t &start, size_t &len)
+{
+    bool inHead = (st == REQUEST_LINE || st == HEADERS);
+    size_t from = pos + scanned;
+    const char *found = ft_memchr(buf.data() + from, '\n', buf.size() - from);
+    if (!found)
+    {
+        scanned = buf.size() - pos;
+        // The head sits at the front of the buffer, so its size is an offset
+        if (inHead ? buf.size() > MAX_HEAD : scanned > MAX_LINE)
+            fail(st == HEADERS ? 431 : 400);
+        return false;
+    }
+    size_t nl = found - buf.data();
+    if (inHead ? nl + 1 > MAX_HEAD : nl - pos > MAX_LINE)
+    {
+        fail(st == HEADERS ? 431 : 400);
+        return false;
+    }
+    start = pos;
+    len = nl - pos;
+    if (len > 0 && buf.data()[nl - 1] == '\r')
+        len--;
+    pos = nl + 1;
+    scanned = 0;
+    return true;
+}
+
+void RequestParser::parseRequestLine(const char *line, size_t len)
+{
+    // Empty lines before a request are allowed (RFC 7230 3.5)
+    if (len == 0)
+        return;
+    std::string *parts[3] = { &req.method, &req.target, &req.version };
+    size_t i = 0;
+    for (int n = 0; n < 3; ++n)
+    {
+        while (i < len && (line[i] == ' ' || line[i] == '\t'))
+            i++;
+        size_t word = i;
+        while (i < len && line[i] != ' ' && line[i] != '\t')
+            i++;
+        parts[n]->assign(line + word, i - word);
+    }
+    if (req.method.empty() || req.target.empty() || req.version.empty())
+    {
+        fail(400);
+        return;
+    }
+    const char *q = ft_memchr(req.target.data(), '?', req.target.size());
+    if (q)
+    {
+        size_t at = q - req.target.data();
+        req.path.assign(req.target, 0, at);
+        req.query.assign(req.target, at + 1, std::string::npos);
+    }
+    else
+        req.path = req.target;
+    st = HEADERS;
+}
+
+void RequestParser::parseHeaderLine(RecvBuffer &buf, size_t start, size_t len)
+{
+    if (len == 0)
+    {
+        finishHead();
+        return;
+    }
+    char *line = buf.data() + start;
+    const char *found = ft_memchr(line, ':', len);
+    if (!found)
+        return; // not a header, ignored as before
+    size_t colon = found - line;
+    size_t from = colon + 1;
+    while (from < len && (line[from] == ' ' || line[from] == '\t'))
+        from++;
+    size_t to = len;
+    while (to > from && (line[to - 1] == ' ' || line[to - 1] == '\t'))
+        to--;
+    ft_strnlower(line, colon);
+
+    HeaderSlice h;
+    h.name = start;
+    h.nameLen = colon;
+    h.value = start + from;
+    h.valueLen = to - from;
+    req.headers.push_back(h);
+}
+
+// Head is over: decide how the body is framed and whether the connection stays open
+void RequestParser::finishHead()
+{
+    if (req.headerIs("connection", "close"))
+        req.keepAlive = false;
+    else if (req.version == "HTTP/1.0" && !req.headerIs("connection", "keep-alive"))
+        req.keepAlive = false;
+
+    if (req.headerHas("transfer-encoding", "chunked"))
+    {
+        req.chunked = true;
+        st = CHUNK_SIZE;
+        return;
+    }
+    const HeaderSlice *h = req.header("content-length");
+    if (h)
+    {
+        const char *value = req.data(h->value);
+        unsigned long length = 0;
+        for (size_t i = 0; i < h->valueLen; ++i)
+        {
+            if (!ft_isdigit(value[i]) || length > (unsigned long)LONG_MAX / 10)
+            {
+                fail(400);
+                return;
+            }
+            length = length * 10 + (value[i] - '0');
+        }
+        if (h->valueLen == 0 || length > (unsigned long)LONG_MAX)
+        {
+            fail(400);
+            return;
+        }
+        req.contentLength = (long)length;
+        remaining = length;
+    }
+    st = remaining > 0 ? BODY : COMPLETE;
+}
+
+void RequestParser::parseChunkSize(const char *line, size_t len)
+{
+    size_t size = 0;
+    size_t i = 0;
+    for (; i < len; ++i)
+    {
+        char c = ft_tolower(line[i]);
+        int digit;
+        if (ft_isdigit(c))
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else
+            break;
+        if (size > ((size_t)-1 >> 4))
+        {
+            fail(400);
+            return;
+        }
+        size = size * 16 + digit;
+    }
+    // Chunk extensions (";name=value") are skipped
+    if (i == 0 || (i < len && line[i] != ';' && line[i] != ' ' && line[i] != '\t'))
+    {
+        fail(400);
+        return;
+    }
+    remaining = size;
+    st = size > 0 ? CHUNK_DATA : TRAILERS;
+}
+
+RequestParser::State RequestParser::parse(RecvBuffer &buf)
+{
+    if (st == COMPLETE)
+    {
+        // The previous request has been handled: its head can go
+        buf.consume(headLen);
+        reset();
+    }
+    req.raw = &buf;
+    size_t pos = headLen;
+    size_t start = 0;
+    size_t len = 0;
+    while (st != COMPLETE && st != FAILED)
+    {
+        if (st == BODY || st == CHUNK_DATA)
+        {
+            size_t take = buf.size() - pos;
+            if (take > remaining)
+                take = remaining;
+            req.body.append(buf.data() + pos, take);
+            pos += take;
+            remaining -= take;
+            if (remaining > 0)
+                break;
+            st = (st == BODY) ? COMPLETE : CHUNK_END;
+            continue;
+        }
+        if (!nextLine(buf, pos, start, len))
+            break;
+        switch (st)
+        {
+        case REQUEST_LINE:
+            parseRequestLine(buf.data() + start, len);
+            headLen = pos;
+            break;
+        case HEADERS:
+            parseHeaderLine(buf, start, len);
+            headLen = pos;
+            break;
+        case CHUNK_SIZE: parseChunkSize(buf.data() + start, len); break;
+        case CHUNK_END:
+            if (len == 0)
+                st = CHUNK_SIZE;
+            else
+                fail(400);
+            break;
+        case TRAILERS:
+            if (len == 0)
+                st = COMPLETE;
+            break;
+        default: break;
+        }
+    }
+    // Body and chunk framing bytes leave the buffer together, the head stays
+    if (pos > headLen)
+        buf.erase(headLen, pos - headLen);
+    return st;
+}
@@ -0,0 +1,102 @@
+#ifndef REQUEST_PARSER_HPP
+#define REQUEST_PARSER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "../utils/RecvBuffer.hpp"
+
+// One header line of a request, as offsets into the buffer the head was parsed from
+struct HeaderSlice
+{
+    size_t name;
+    size_t nameLen;
+    size_t value;
+    size_t valueLen;
+};
+
+// A request as handed to the router: head parsed once, body already de-chunked.
+// Header names and values are not copied: `headers` points into the connection's
+// receive buffer, which keeps the head until the next request starts.
+// Names are lower-cased in place, so lookups take lower-case names.
+struct HttpRequest
+{
+    std::string method;
+    std::string target;   // as sent, query included
+    std::string path;     // target without the query
+    std::string query;
+    std::string version;
+    std::vector<HeaderSlice> headers;
+    const RecvBuffer *raw;  // buffer the slices point into
+    std::string body;
+    long contentLength;   // -1 when the header is absent
+    bool chunked;
+    bool keepAlive;       // what the client asked for (Connection header / version)
+
+    HttpRequest();
+    void clear();
+
+    // Last header called `name` (a repeated header replaces the earlier ones)
+    const HeaderSlice *header(const char *name) const;
+    const char *data(size_t offset) const { return raw->data() + offset; }
+    // Case-insensitive comparisons on a header value; false when the header is absent
+    bool headerIs(const char *name, const char *value) const;
+    bool headerHas(const char *name, const char *token) const;
+};
+
+// Resumable HTTP/1.x request parser, one per connection.
+// parse() eats whatever part of the buffer it can use and remembers where it
+// stopped, so every byte is looked at once however the request is split across
+// reads. Lines may end in CRLF or a bare LF.
+class RequestParser
+{
+public:
+    enum State
+    {
+        REQUEST_LINE,
+        HEADERS,
+        BODY,        // Content-Length bytes
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_END,   // CRLF after a chunk
+        TRAILERS,
+        COMPLETE,
+        FAILED
+    };
+
+    RequestParser();
+
+    // Consumes bytes from buf; the head stays at its front for the header slices,
+    // body bytes are moved into the request. After COMPLETE the next call drops
+    // the head and starts a new request with what is left (pipelining);
+    // FAILED is final until reset().
+    State parse(RecvBuffer &buf);
+    void reset();
+
+    State state() const;
+    bool started() const;      // part of a request has been consumed
+    bool headComplete() const; // headers done, body pending or done
+    int error() const;         // status to answer with once FAILED
+
+    const HttpRequest &request() const;
+    HttpRequest &request();
+
+private:
+    enum { MAX_HEAD = 65536, MAX_LINE = 8192 };
+
+    State st;
+    HttpRequest req;
+    size_t headLen;   // bytes at the front of the buffer that belong to the head
+    size_t scanned;   // bytes past the read position already known to hold no '\n'
+    size_t remaining; // body or chunk bytes still expected
+    int errorCode;
+
+    bool nextLine(const RecvBuffer &buf, size_t &pos, size_t &start, size_t &len);
+    void parseRequestLine(const char *line, size_t len);
+    void parseHeaderLine(RecvBuffer &buf, size_t start, size_t len);
+    void finishHead();
+    void parseChunkSize(const char *line, size_t len);
+    void fail(int code);
+};
+
+#endif
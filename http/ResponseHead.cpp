@@ -0,0 +1,184 @@
+#include "ResponseHead.hpp"
+#include <cstring>
+
+static const char SERVER_LINE[] = "Server: WebServer/1.0\r\n";
+
+struct StatusLine
+{
+    int code;
+    const char *line;
+};
+
+// The statuses sent on every other request; others are put together from statusReason()
+static const StatusLine STATUS_LINES[] = {
+    {200, "HTTP/1.1 200 OK\r\n"},
+    {204, "HTTP/1.1 204 No Content\r\n"},
+    {206, "HTTP/1.1 206 Partial Content\r\n"},
+    {304, "HTTP/1.1 304 Not Modified\r\n"},
+    {404, "HTTP/1.1 404 Not Found\r\n"},
+    {416, "HTTP/1.1 416 Range Not Satisfiable\r\n"},
+    {500, "HTTP/1.1 500 Internal Server Error\r\n"},
+    {0, 0}};
+
+size_t formatDecimal(char *out, unsigned long value)
+{
+    char digits[20];
+    size_t n = 0;
+    do
+    {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    for (size_t i = 0; i < n; ++i)
+        out[i] = digits[n - 1 - i];
+    return n;
+}
+
+GeneralHeaders::GeneralHeaders() : second(-1), len(0) {}
+
+const char *GeneralHeaders::data()
+{
+    time_t now = time(NULL);
+    if (now != second)
+    {
+        struct tm tm;
+        gmtime_r(&now, &tm);
+        len = strftime(buf, sizeof(buf), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+        std::memcpy(buf + len, SERVER_LINE, sizeof(SERVER_LINE) - 1);
+        len += sizeof(SERVER_LINE) - 1;
+        second = now;
+    }
+    return buf;
+}
+
+size_t GeneralHeaders::size() const
+{
+    return len;
+}
+
+ResponseHead::ResponseHead(int status, GeneralHeaders &general) : len(0)
+{
+    const char *line = 0;
+    for (size_t i = 0; STATUS_LINES[i].code; ++i)
+    {
+        if (STATUS_LINES[i].code == status)
+            line = STATUS_LINES[i].line;
+    }
+    if (line)
+        put(line);
+    else
+    {
+        put("HTTP/1.1 ");
+        putNumber((unsigned long)status);
+        put(" ");
+        put(statusReason(status));
+        put("\r\n");
+    }
+    const char *common = general.data(); // before size(): it may move to a new second
+    put(common, general.size());
+}
+
+void ResponseHead::put(const char *data, size_t n)
+{
+    if (spill.empty() && len + n <= CAPACITY)
+    {
+        std::memcpy(buf + len, data, n);
+        len += n;
+        return;
+    }
+    if (spill.empty())
+        spill.assign(buf, len);
+    spill.append(data, n);
+}
+
+void ResponseHead::put(const char *text)
+{
+    put(text, std::strlen(text));
+}
+
+void ResponseHead::putNumber(unsigned long value)
+{
+    char digits[20];
+    put(digits, formatDecimal(digits, value));
+}
+
+ResponseHead &ResponseHead::header(const char *name, const std::string &value)
+{
+    put(name);
+    put(": ", 2);
+    put(value.data(), value.size());
+    put("\r\n", 2);
+    return *this;
+}
+
+ResponseHead &ResponseHead::header(const char *name, const char *value)
+{
+    put(name);
+    put(": ", 2);
+    put(value);
+    put("\r\n", 2);
+    return *this;
+}
+
+ResponseHead &ResponseHead::header(const char *name, unsigned long value)
+{
+    put(name);
+    put(": ", 2);
+    putNumber(value);
+    put("\r\n", 2);
+    return *this;
+}
+
+ResponseHead &ResponseHead::lines(const std::string &formatted)
+{
+    put(formatted.data(), formatted.size());
+    return *this;
+}
+
+ResponseHead &ResponseHead::lines(const char *formatted, size_t length)
+{
+    put(formatted, length);
+    return *this;
+}
+
+ResponseHead &ResponseHead::contentRange(const ByteRange *range, off_t size)
+{
+    put("Content-Range: bytes ");
+    if (range)
+    {
+        putNumber((unsigned long)range->first);
+        put("-", 1);
+        putNumber((unsigned long)range->last);
+    }
+    else
+        put("*", 1);
+    put("/", 1);
+    putNumber((unsigned long)size);
+    put("\r\n", 2);
+    return *this;
+}
+
+ResponseHead &ResponseHead::connection(bool keepAlive)
+{
+    if (keepAlive)
+        put("Connection: keep-alive\r\n");
+    else
+        put("Connection: close\r\n");
+    return *this;
+}
+
+ResponseHead &ResponseHead::end()
+{
+    put("\r\n", 2);
+    return *this;
+}
+
+const char *ResponseHead::data() const
+{
+    return spill.empty() ? buf : spill.data();
+}
+
+size_t ResponseHead::size() const
+{
+    return spill.empty() ? len : spill.size();
+}
@@ -0,0 +1,70 @@
+#ifndef RESPONSE_HEAD_HPP
+#define RESPONSE_HEAD_HPP
+
+#include <cstddef>
+#include <ctime>
+#include <string>
+#include <sys/types.h>
+#include "HttpUtils.hpp"
+
+// The Date and Server lines every response carries. Date is formatted again
+// only when the second changes; each worker has its own, so no locking.
+class GeneralHeaders
+{
+public:
+    GeneralHeaders();
+    // "Date: <IMF-fixdate>\r\nServer: WebServer/1.0\r\n" for the current second
+    const char *data();
+    size_t size() const;
+
+private:
+    time_t second;
+    char buf[96];
+    size_t len;
+};
+
+// Status line and header lines of one response, written into a fixed buffer
+// with no allocation and no stream formatting: the status line comes from a
+// table, numbers are formatted by hand. The general headers follow the status
+// line; end() adds the blank line.
+class ResponseHead
+{
+public:
+    enum
+    {
+        CAPACITY = 1024 // a longer head spills into a string
+    };
+
+    ResponseHead(int status, GeneralHeaders &general);
+
+    ResponseHead &header(const char *name, const std::string &value);
+    ResponseHead &header(const char *name, const char *value);
+    ResponseHead &header(const char *name, unsigned long value);
+    // Header lines already formatted, each ending in CRLF
+    ResponseHead &lines(const std::string &formatted);
+    ResponseHead &lines(const char *formatted, size_t length);
+    // "Content-Range: bytes first-last/size", or "bytes */size" without a range
+    ResponseHead &contentRange(const ByteRange *range, off_t size);
+    ResponseHead &connection(bool keepAlive);
+    ResponseHead &end();
+
+    const char *data() const;
+    size_t size() const;
+
+private:
+    char buf[CAPACITY];
+    size_t len;
+    std::string spill; // the whole head once it outgrew buf
+
+    void put(const char *data, size_t n);
+    void put(const char *text);
+    void putNumber(unsigned long value);
+
+    ResponseHead(const ResponseHead &);
+    ResponseHead &operator=(const ResponseHead &);
+};
+
+// Decimal digits of value written at out (room for 20 needed), returns how many
+size_t formatDecimal(char *out, unsigned long value);
+
+#endif
@@ -1,6 +1,7 @@
 #include "Logger.hpp"
 #include <iostream>
 #include <sstream>
+#include <pthread.h>
 
 namespace {
     const char* C_RESET = "\033[0m";
@@ -10,6 +11,9 @@ namespace {
     const char* C_GET    = "\033[34m";   // blue
     const char* C_POST   = "\033[33m";   // yellow
     const char* C_DELETE = "\033[31m";   // red
+
+    // Workers log from several threads; keep each line in one piece
+    pthread_mutex_t g_logMutex = PTHREAD_MUTEX_INITIALIZER;
 }
 
 namespace Logger {
@@ -21,7 +25,9 @@ namespace Logger {
     static void logColored(const char* color, const std::string& tag, const std::string& msg) 
     {
         if (!isLoggingEnabled()) return;
+        pthread_mutex_lock(&g_logMutex);
         std::cout << color << tag << " " << msg << C_RESET << std::endl;
+        pthread_mutex_unlock(&g_logMutex);
     }
 
     void info(const std::string &msg)
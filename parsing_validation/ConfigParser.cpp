@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <unistd.h>
 
 static void throwError(const std::string& msg, int lineNum) {
     std::ostringstream oss;
@@ -24,6 +25,22 @@ bool ConfigParser::validateConfigFile(const std::string &filename)
     return validator.validate();
 }
 
+// The Timeouts field a *_timeout directive sets, or NULL for any other directive
+static int *timeoutField(const std::string &line, Timeouts &timeouts)
+{
+    if (line.find("keepalive_timeout") == 0)
+        return &timeouts.keepalive;
+    if (line.find("header_timeout") == 0)
+        return &timeouts.header;
+    if (line.find("body_timeout") == 0)
+        return &timeouts.body;
+    if (line.find("send_timeout") == 0)
+        return &timeouts.send;
+    if (line.find("cgi_timeout") == 0)
+        return &timeouts.cgi;
+    return NULL;
+}
+
 // helpers are implemented in ConfigParser_Utils.cpp and cp_removeComments() in ConfigParser_Internal.cpp
 
 Servers ConfigParser::parseServers()
@@ -40,7 +57,9 @@ Servers ConfigParser::parseServers()
     Location currentLoc;
     bool inLocation = false;
     bool inServer = false;
+    bool inTypes = false;
     int lineNum = 0;
+    int defaultLine = 0; // listen ... default_server of the current server
     Server currentServer;
 
     while (ft_getline(file, line))
@@ -53,6 +72,15 @@ Servers ConfigParser::parseServers()
         if (line.empty())
             continue;
 
+        if (inTypes)
+        {
+            if (line == "}")
+                inTypes = false;
+            else if (line != "{")
+                servers.mime.addEntry(line);
+            continue;
+        }
+
         // Detect start of a server block
         if (line.find("server") == 0 && !inServer)
         {
@@ -84,7 +112,48 @@ Servers ConfigParser::parseServers()
             continue;
 
         if (!inServer)
+        {
+            // Global directives (outside every server block)
+            if (line.find("types") == 0)
+                inTypes = true;
+            else if (line.find("include") == 0)
+            {
+                if (!servers.mime.load(getValue(line)))
+                    throwError("Cannot read types file", lineNum);
+            }
+            else if (line.find("default_type") == 0)
+                servers.mime.setDefault(getValue(line));
+            else if (line.find("event_engine") == 0)
+                servers.event_engine = getValue(line);
+            else if (line.find("workers") == 0)
+            {
+                std::string val = getValue(line);
+                if (val == "auto")
+                {
+                    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                    servers.workers = cpus > 0 ? (int)cpus : 1;
+                }
+                else
+                    servers.workers = ft_atoi(val.c_str());
+            }
+            else if (line.find("max_connections") == 0)
+                servers.max_connections = ft_atoi(getValue(line).c_str());
+            else if (line.find("content_cache_max_file") == 0)
+                servers.content_cache_max_file = ft_atol(getValue(line).c_str());
+            else if (line.find("content_cache") == 0)
+                servers.content_cache = ft_atol(getValue(line).c_str());
+            else if (line.find("gzip_comp_level") == 0)
+                servers.gzip_comp_level = ft_atoi(getValue(line).c_str());
+            else if (line.find("gzip_min_length") == 0)
+                servers.gzip_min_length = ft_atol(getValue(line).c_str());
+            else if (line.find("gzip_cache") == 0)
+                servers.gzip_cache = ft_atol(getValue(line).c_str());
+            else if (line.find("open_file_cache_valid") == 0)
+                servers.open_file_cache_valid = ft_atoi(getValue(line).c_str());
+            else if (line.find("open_file_cache") == 0)
+                servers.open_file_cache = ft_atoi(getValue(line).c_str());
             continue;
+        }
 
         // Check for semicolons
         if (lineRequiresSemicolon(line) && line[line.size() - 1] != ';')
@@ -94,11 +163,7 @@ Servers ConfigParser::parseServers()
         {
             if (inLocation)
             {
-                if (currentServer.location_count < 10)
-                    currentServer.locations[currentServer.location_count++] = currentLoc;
-                else
-                    std::cerr << "Warning: Maximum 10 locations supported. Ignoring location: "
-                              << currentLoc.path << std::endl;
+                currentServer.locations.push_back(currentLoc);
                 inLocation = false;
             }
             else if (inServer)
@@ -115,9 +180,22 @@ Servers ConfigParser::parseServers()
                     throwError("Missing required directive 'root'", lineNum);
                 if (currentServer.index.empty())
                     throwError("Missing required directive 'index'", lineNum);
-                if (currentServer.location_count == 0)
+                if (currentServer.locations.empty())
                     throwError("Server must have at least one location", lineNum);
 
+                // As in nginx, one address has at most one default server
+                for (size_t i = 0; currentServer.default_server && i < servers.servers.size(); ++i)
+                {
+                    const Server &other = servers.servers[i];
+                    if (other.default_server && other.host == currentServer.host && other.listen == currentServer.listen)
+                    {
+                        std::ostringstream address;
+                        address << currentServer.host << ":" << currentServer.listen;
+                        throwError("Duplicate default server for " + address.str(), defaultLine);
+                    }
+                }
+
+                currentServer.router.compile(currentServer.locations);
                 // Add completed server to servers collection
                 servers.addServer(currentServer);
                 continue;
@@ -129,6 +207,13 @@ Servers ConfigParser::parseServers()
         if (line.find("listen") == 0)
         {
             std::string val = getValue(line);
+            size_t option = val.find_first_of(" \t");
+            if (option != std::string::npos)
+            {
+                currentServer.default_server = trim(ft_substr(val, option)) == "default_server";
+                defaultLine = lineNum;
+                val = ft_substr(val, 0, option);
+            }
             if (!val.empty())
             {
                 size_t colonPos = val.find(':');
@@ -166,6 +251,24 @@ Servers ConfigParser::parseServers()
             }
             currentServer.max_size = val;
         }
+        else if (line.find("max_connections") == 0 && !inLocation)
+        {
+            std::string val = getValue(line);
+            if (val.empty())
+            {
+                throwError("Missing value for 'max_connections'", lineNum);
+            }
+            currentServer.max_connections = ft_atoi(val.c_str());
+        }
+        else if (!inLocation && timeoutField(line, currentServer.timeouts))
+        {
+            std::string val = getValue(line);
+            if (val.empty())
+            {
+                throwError("Missing value for timeout", lineNum);
+            }
+            *timeoutField(line, currentServer.timeouts) = ft_atoi(val.c_str());
+        }
         else if (line.find("server_name") == 0)
         {
             std::string val = getValue(line);
@@ -294,6 +397,20 @@ Servers ConfigParser::parseServers()
                 else if (val == "off")
                     currentLoc.autoindex = false;
             }
+            else if (line.find("etag") == 0)
+            {
+                currentLoc.etag = getValue(line) == "on";
+            }
+            else if (line.find("gzip") == 0)
+            {
+                currentLoc.gzip = getValue(line) == "on";
+            }
+            else if (line.find("precompressed") == 0)
+            {
+                std::string val = getValue(line);
+                currentLoc.precompressed = (val == "on" || val == "generate");
+                currentLoc.precompress_startup = (val == "generate");
+            }
             else if (line.find("index") == 0)
             {
                 std::string val = getValue(line);
@@ -303,6 +420,15 @@ Servers ConfigParser::parseServers()
                 }
                 currentLoc.index = val;
             }
+            else if (timeoutField(line, currentLoc.timeouts))
+            {
+                std::string val = getValue(line);
+                if (val.empty())
+                {
+                    throwError("Missing value for timeout", lineNum);
+                }
+                *timeoutField(line, currentLoc.timeouts) = ft_atoi(val.c_str());
+            }
             else if (line.find("return") == 0)
             {
                 std::istringstream iss(line);
@@ -317,5 +443,6 @@ Servers ConfigParser::parseServers()
         }
     }
 
+    servers.vhosts.compile(servers.servers);
     return servers;
 }
@@ -5,6 +5,24 @@
 #include <map>
 #include <set>
 #include <vector>
+#include "LocationRouter.hpp"
+#include "MimeTypes.hpp"
+#include "VirtualHosts.hpp"
+
+// Deadlines in seconds. A Location leaves a field at -1 to inherit it from its Server.
+struct Timeouts
+{
+    int keepalive; // idle connection between requests
+    int header;    // receiving the request head
+    int body;      // between two chunks of the request body
+    int send;      // between two chunks of the response
+    int cgi;       // running a CGI script
+
+    explicit Timeouts(int value)
+    {
+        keepalive = header = body = send = cgi = value;
+    }
+};
 
 struct Location
 {
@@ -15,12 +33,17 @@ struct Location
     std::vector<std::string> cgi_extensions;
     std::string upload_path;
     bool autoindex;
+    bool etag; // ETag/Last-Modified on static files and 304 answers to conditional GETs
+    bool precompressed;       // serve file.br / file.gz to clients accepting them
+    bool precompress_startup; // and write the missing .gz files when the server starts
+    bool gzip;                // compress listings, CGI output and error pages on the fly
     std::pair<int, std::string> redirect;
     bool allow_get;
     bool allow_post;
     bool allow_delete;
+    Timeouts timeouts;
 
-    Location()
+    Location() : timeouts(-1)
     {
         path = "";
         root = "";
@@ -28,6 +51,10 @@ struct Location
         upload_path = "";
         // cgi_extensions is empty by default
         autoindex = false;
+        etag = true;
+        precompressed = false;
+        precompress_startup = false;
+        gzip = false;
         redirect = std::make_pair(0, "");
         allow_get = true;
         allow_post = true;
@@ -40,22 +67,31 @@ struct Server
     int listen;
     std::string host;
     std::string max_size;
-    std::string server_name;
+    std::string server_name; // one or more names, "*.example.com" and "www.example.*" allowed
+    bool default_server;     // answers requests on its host:port that no server_name matches
     std::string root;
     std::string index;
     std::map<int, std::string> error_pages;
-    Location locations[10];
-    int location_count;
+    std::vector<Location> locations;
+    LocationRouter router; // compiled from locations once the server block is parsed
+    int max_connections; // 0 = only bounded by the global limit
+    Timeouts timeouts;
 
-    Server() 
+    Server() : timeouts(0)
     {
         listen = 0;
         host = "";
         max_size = "";
         server_name = "";
+        default_server = false;
         root = "";
         index = "";
-        location_count = 0;
+        max_connections = 0;
+        timeouts.keepalive = 60;
+        timeouts.header = 30;
+        timeouts.body = 60;
+        timeouts.send = 60;
+        timeouts.cgi = 5;
     }
 
 };
@@ -64,8 +100,32 @@ struct Server
 struct Servers
 {
     std::vector<Server> servers;
+    std::string event_engine; // "epoll" (default), "select" or "io_uring"
+    int workers;              // number of event loop threads
+    int max_connections;      // whole process; 0 = derived from RLIMIT_NOFILE
+    int open_file_cache;      // open descriptors of static files kept per worker; 0 = off
+    int open_file_cache_valid; // seconds before a cached file is checked again
+    long content_cache;       // bytes of small files kept in memory per worker; 0 = off
+    long content_cache_max_file; // larger files are always sent from disk
+    int gzip_comp_level;      // on-the-fly gzip, 1 (fast) to 9 (small)
+    long gzip_min_length;     // smaller bodies are sent as they are
+    long gzip_cache;          // bytes of compressed bodies kept per worker; 0 = off
+    MimeTypes mime;           // Content-Type by file extension
+    VirtualHosts vhosts;      // listening addresses and Host dispatch, compiled after parsing
 
-    Servers() {}
+    Servers()
+    {
+        event_engine = "epoll";
+        workers = 1;
+        max_connections = 0;
+        open_file_cache = 256;
+        open_file_cache_valid = 10;
+        content_cache = 32 * 1024 * 1024;
+        content_cache_max_file = 256 * 1024;
+        gzip_comp_level = 6;
+        gzip_min_length = 256;
+        gzip_cache = 4 * 1024 * 1024;
+    }
 
     void addServer(const Server &server)
     {
@@ -238,6 +238,21 @@ bool ConfigValidator::validateSyntax()
             continue;
         }
 
+        if (line.find("types") == 0 && (line.size() == 5 || line[5] == ' ' || line[5] == '\t' || line[5] == '{'))
+        {
+            if (!validateTypesBlock(i))
+                return false;
+            continue;
+        }
+
+        if (isGlobalDirective(line))
+        {
+            if (!validateGlobalDirective(line, i + 1))
+                return false;
+            i++;
+            continue;
+        }
+
         printError("Unexpected directive outside server block: '" + line + "'", i + 1);
         return false;
     }
@@ -376,6 +391,17 @@ bool ConfigValidator::validateDirective(const std::string &line, int lineNum, bo
             return false;
         }
 
+        std::string option;
+        if ((iss >> option) && option != ";")
+        {
+            if (option[option.size() - 1] == ';')
+                option = ft_substr(option, 0, option.size() - 1);
+            if (option != "default_server")
+            {
+                printError("Unknown 'listen' parameter: '" + option + "'", lineNum);
+                return false;
+            }
+        }
         if (!checkExtraArguments(iss, "listen", lineNum))
             return false;
     }
@@ -417,6 +443,28 @@ bool ConfigValidator::validateDirective(const std::string &line, int lineNum, bo
         if (!checkExtraArguments(iss, "max_size", lineNum))
             return false;
     }
+    else if (directive == "max_connections")
+    {
+        if (inLocation)
+        {
+            printError("'max_connections' directive not allowed in location block", lineNum);
+            return false;
+        }
+        if (!validateNumber(iss, "max_connections", lineNum, 1, 10000000))
+            return false;
+    }
+    else if (directive == "keepalive_timeout" || directive == "header_timeout" ||
+             directive == "body_timeout" || directive == "send_timeout" || directive == "cgi_timeout")
+    {
+        // The request head is read before any location is known
+        if (inLocation && directive == "header_timeout")
+        {
+            printError("'header_timeout' directive not allowed in location block", lineNum);
+            return false;
+        }
+        if (!validateNumber(iss, directive, lineNum, 1, 86400))
+            return false;
+    }
     else if (directive == "server_name")
     {
         if (inLocation)
@@ -425,19 +473,27 @@ bool ConfigValidator::validateDirective(const std::string &line, int lineNum, bo
             return false;
         }
         std::string name;
-        if (!(iss >> name))
+        if (!(iss >> name) || name == ";")
         {
             printError("'server_name' directive missing value", lineNum);
             return false;
         }
-        
-        if (!name.empty() && name[name.size() - 1] == ';')
+        // Several names may follow; '*' only as a whole first or last label
+        do
         {
-            name = ft_substr(name, 0, name.size() - 1);
-        }
-
-        if (!checkExtraArguments(iss, "server_name", lineNum))
-            return false;
+            if (name == ";")
+                return checkExtraArguments(iss, "server_name", lineNum);
+            if (!name.empty() && name[name.size() - 1] == ';')
+                name = ft_substr(name, 0, name.size() - 1);
+            size_t star = name.find('*');
+            bool leading = star == 0 && name.size() > 2 && name[1] == '.';
+            bool trailing = star == name.size() - 1 && name.size() > 2 && name[star - 1] == '.';
+            if (star != std::string::npos && ((!leading && !trailing) || name.find('*', star + 1) != std::string::npos))
+            {
+                printError("Invalid wildcard in server_name: '" + name + "'", lineNum);
+                return false;
+            }
+        } while (iss >> name);
     }
     else if (directive == "root")
     {
@@ -598,6 +654,78 @@ bool ConfigValidator::validateDirective(const std::string &line, int lineNum, bo
         if (!checkExtraArguments(iss, "autoindex", lineNum))
             return false;
     }
+    else if (directive == "etag")
+    {
+        if (!inLocation)
+        {
+            printError("'etag' directive only allowed in location block", lineNum);
+            return false;
+        }
+        std::string val;
+        if (!(iss >> val))
+        {
+            printError("'etag' directive missing value (on/off)", lineNum);
+            return false;
+        }
+        if (!val.empty() && val[val.size() - 1] == ';')
+            val = ft_substr(val, 0, val.size() - 1);
+        if (val != "on" && val != "off")
+        {
+            printError("Invalid value for 'etag' (expected on/off)", lineNum);
+            return false;
+        }
+
+        if (!checkExtraArguments(iss, "etag", lineNum))
+            return false;
+    }
+    else if (directive == "gzip")
+    {
+        if (!inLocation)
+        {
+            printError("'gzip' directive only allowed in location block", lineNum);
+            return false;
+        }
+        std::string val;
+        if (!(iss >> val))
+        {
+            printError("'gzip' directive missing value (on/off)", lineNum);
+            return false;
+        }
+        if (!val.empty() && val[val.size() - 1] == ';')
+            val = ft_substr(val, 0, val.size() - 1);
+        if (val != "on" && val != "off")
+        {
+            printError("Invalid value for 'gzip' (expected on/off)", lineNum);
+            return false;
+        }
+
+        if (!checkExtraArguments(iss, "gzip", lineNum))
+            return false;
+    }
+    else if (directive == "precompressed")
+    {
+        if (!inLocation)
+        {
+            printError("'precompressed' directive only allowed in location block", lineNum);
+            return false;
+        }
+        std::string val;
+        if (!(iss >> val))
+        {
+            printError("'precompressed' directive missing value (on/off/generate)", lineNum);
+            return false;
+        }
+        if (!val.empty() && val[val.size() - 1] == ';')
+            val = ft_substr(val, 0, val.size() - 1);
+        if (val != "on" && val != "off" && val != "generate")
+        {
+            printError("Invalid value for 'precompressed' (expected on/off/generate)", lineNum);
+            return false;
+        }
+
+        if (!checkExtraArguments(iss, "precompressed", lineNum))
+            return false;
+    }
 	
     else if (directive != "location" && directive != "server")
     {
@@ -608,6 +736,231 @@ bool ConfigValidator::validateDirective(const std::string &line, int lineNum, bo
     return true;
 }
 
+bool ConfigValidator::isGlobalDirective(const std::string &line)
+{
+    std::string directive = ft_substr(line, 0, line.find_first_of(" \t;"));
+    return directive == "event_engine" || directive == "workers" || directive == "max_connections" ||
+           directive == "open_file_cache" || directive == "open_file_cache_valid" ||
+           directive == "content_cache" || directive == "content_cache_max_file" ||
+           directive == "gzip_comp_level" || directive == "gzip_min_length" || directive == "gzip_cache" ||
+           directive == "include" || directive == "default_type";
+}
+
+// Directives that apply to the whole process and live outside any server block
+bool ConfigValidator::validateGlobalDirective(const std::string &line, int lineNum)
+{
+    std::istringstream iss(line);
+    std::string directive;
+    iss >> directive;
+
+    if (line[line.size() - 1] != ';')
+    {
+        printError("Missing semicolon after '" + directive + "'", lineNum);
+        return false;
+    }
+
+    if (directive == "event_engine")
+    {
+        std::string value;
+        if (!(iss >> value))
+        {
+            printError("'event_engine' directive missing value", lineNum);
+            return false;
+        }
+        if (!value.empty() && value[value.size() - 1] == ';')
+            value = ft_substr(value, 0, value.size() - 1);
+        if (value != "epoll" && value != "select" && value != "io_uring")
+        {
+            printError("Invalid value for 'event_engine' (expected epoll/select/io_uring)", lineNum);
+            return false;
+        }
+
+        if (!checkExtraArguments(iss, "event_engine", lineNum))
+            return false;
+    }
+    else if (directive == "workers")
+    {
+        std::string value;
+        if (!(iss >> value))
+        {
+            printError("'workers' directive missing value", lineNum);
+            return false;
+        }
+        if (!value.empty() && value[value.size() - 1] == ';')
+            value = ft_substr(value, 0, value.size() - 1);
+        if (value != "auto")
+        {
+            for (size_t i = 0; i < value.size(); ++i)
+            {
+                if (!ft_isdigit(value[i]))
+                {
+                    printError("Invalid value for 'workers' (expected a number or auto)", lineNum);
+                    return false;
+                }
+            }
+            int n = ft_atoi(value.c_str());
+            if (value.empty() || value.size() > 3 || n < 1 || n > 256)
+            {
+                printError("'workers' must be between 1 and 256", lineNum);
+                return false;
+            }
+        }
+
+        if (!checkExtraArguments(iss, "workers", lineNum))
+            return false;
+    }
+    else if (directive == "max_connections")
+    {
+        if (!validateNumber(iss, "max_connections", lineNum, 1, 10000000))
+            return false;
+    }
+    else if (directive == "open_file_cache")
+    {
+        if (!validateNumber(iss, "open_file_cache", lineNum, 0, 100000))
+            return false;
+    }
+    else if (directive == "open_file_cache_valid")
+    {
+        if (!validateNumber(iss, "open_file_cache_valid", lineNum, 0, 86400))
+            return false;
+    }
+    else if (directive == "content_cache")
+    {
+        if (!validateNumber(iss, "content_cache", lineNum, 0, 4294967295L))
+            return false;
+    }
+    else if (directive == "content_cache_max_file")
+    {
+        if (!validateNumber(iss, "content_cache_max_file", lineNum, 0, 1073741824L))
+            return false;
+    }
+    else if (directive == "gzip_comp_level")
+    {
+        if (!validateNumber(iss, "gzip_comp_level", lineNum, 1, 9))
+            return false;
+    }
+    else if (directive == "gzip_min_length")
+    {
+        if (!validateNumber(iss, "gzip_min_length", lineNum, 0, 1073741824L))
+            return false;
+    }
+    else if (directive == "gzip_cache")
+    {
+        if (!validateNumber(iss, "gzip_cache", lineNum, 0, 4294967295L))
+            return false;
+    }
+    else if (directive == "include" || directive == "default_type")
+    {
+        std::string value;
+        if (!(iss >> value) || value == ";")
+        {
+            printError("'" + directive + "' directive missing value", lineNum);
+            return false;
+        }
+        if (value[value.size() - 1] == ';')
+            value = ft_substr(value, 0, value.size() - 1);
+        if (directive == "include")
+        {
+            std::ifstream types(value.c_str());
+            if (!types.is_open())
+            {
+                printError("Cannot open types file '" + value + "'", lineNum);
+                return false;
+            }
+        }
+        else if (value.find('/') == std::string::npos)
+        {
+            printError("Invalid value for 'default_type' (expected a MIME type)", lineNum);
+            return false;
+        }
+        if (!checkExtraArguments(iss, directive, lineNum))
+            return false;
+    }
+    return true;
+}
+
+// types { type ext ...; } : one entry per line, the closing brace on its own line
+bool ConfigValidator::validateTypesBlock(size_t &idx)
+{
+    std::string line = trim(lines[idx]);
+    std::string rest = trim(ft_substr(line, 5));
+    idx++;
+    if (rest.empty())
+    {
+        while (idx < lines.size() && trim(lines[idx]).empty())
+            idx++;
+        if (idx >= lines.size() || trim(lines[idx]) != "{")
+        {
+            printError("Missing opening brace '{' after 'types' directive", idx);
+            return false;
+        }
+        idx++;
+    }
+    else if (rest != "{")
+    {
+        printError("Unexpected text after 'types'", idx);
+        return false;
+    }
+
+    while (idx < lines.size())
+    {
+        line = trim(lines[idx]);
+        idx++;
+        if (line.empty())
+            continue;
+        if (line == "}")
+            return true;
+
+        if (line[line.size() - 1] != ';')
+        {
+            printError("Missing semicolon after types entry", idx);
+            return false;
+        }
+        std::istringstream iss(ft_substr(line, 0, line.size() - 1));
+        std::string type;
+        std::string extension;
+        iss >> type;
+        if (type.find('/') == std::string::npos || !(iss >> extension))
+        {
+            printError("Invalid types entry (expected 'type extension ...;')", idx);
+            return false;
+        }
+    }
+    printError("Missing closing brace '}' for 'types' block");
+    return false;
+}
+
+// Reads one integer argument and checks it lies within [min, max]
+bool ConfigValidator::validateNumber(std::istringstream &iss, const std::string &directiveName, int lineNum,
+                                     long min, long max)
+{
+    std::string value;
+    if (!(iss >> value))
+    {
+        printError("'" + directiveName + "' directive missing value", lineNum);
+        return false;
+    }
+    if (!value.empty() && value[value.size() - 1] == ';')
+        value = ft_substr(value, 0, value.size() - 1);
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        if (!ft_isdigit(value[i]))
+        {
+            printError("Invalid value for '" + directiveName + "' (expected a number)", lineNum);
+            return false;
+        }
+    }
+    long n = ft_atol(value.c_str());
+    if (value.empty() || value.size() > 10 || n < min || n > max)
+    {
+        std::ostringstream oss;
+        oss << "'" << directiveName << "' must be between " << min << " and " << max;
+        printError(oss.str(), lineNum);
+        return false;
+    }
+    return checkExtraArguments(iss, directiveName, lineNum);
+}
+
 bool ConfigValidator::validateBlockDeclaration(const std::string &line, const std::string &blockType,
                                                int lineNum, std::string &path)
 {
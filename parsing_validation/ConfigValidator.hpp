@@ -17,6 +17,8 @@ private:
     bool isValidErrorCode(int code);
     bool isValidHost(const std::string &host);
     bool checkExtraArguments(std::istringstream &iss, const std::string &directiveName, int lineNum);
+    bool validateNumber(std::istringstream &iss, const std::string &directiveName, int lineNum,
+                        long min, long max);
     void printError(const std::string &msg, int lineNum = -1);
     
     // Validation functions
@@ -25,6 +27,9 @@ private:
     bool validateServerBlock(size_t &idx);
     bool validateLocationBlock(size_t &idx);
     bool validateDirective(const std::string &line, int lineNum, bool inLocation);
+    bool isGlobalDirective(const std::string &line);
+    bool validateGlobalDirective(const std::string &line, int lineNum);
+    bool validateTypesBlock(size_t &idx);
     bool checkDuplicateServerConfigs();
     bool validateBlockDeclaration(const std::string &line, const std::string &blockType, 
                                    int lineNum, std::string &path);
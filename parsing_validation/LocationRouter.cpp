@@ -0,0 +1,70 @@
+#include "LocationRouter.hpp"
+#include "ConfigStructs.hpp"
+
+int LocationRouter::child(std::vector<Node> &trie, int node, unsigned char c)
+{
+    std::map<unsigned char, int>::iterator it = trie[node].next.find(c);
+    if (it != trie[node].next.end())
+        return it->second;
+    // Indexes, not references: push_back may move the nodes
+    trie.push_back(Node());
+    int created = (int)trie.size() - 1;
+    trie[node].next[c] = created;
+    return created;
+}
+
+void LocationRouter::compile(const std::vector<Location> &locations)
+{
+    prefixes.assign(1, Node());
+    suffixes.assign(1, Node());
+    for (size_t i = 0; i < locations.size(); ++i)
+    {
+        const std::string &lp = locations[i].path;
+        if (lp.empty())
+            continue;
+        if (lp[0] == '*' && lp.size() > 1)
+        {
+            int node = 0;
+            for (size_t j = lp.size() - 1; j >= 1; --j)
+                node = child(suffixes, node, (unsigned char)lp[j]);
+            suffixes[node].location = (int)i; // a later pattern overrides an identical one
+            continue;
+        }
+        int node = 0;
+        for (size_t j = 0; j < lp.size(); ++j)
+            node = child(prefixes, node, (unsigned char)lp[j]);
+        if (prefixes[node].location < 0)
+            prefixes[node].location = (int)i;
+    }
+}
+
+void LocationRouter::match(const std::string &path, int &prefix, int &suffix) const
+{
+    prefix = -1;
+    suffix = -1;
+    if (prefixes.empty())
+        return;
+
+    int node = 0;
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        std::map<unsigned char, int>::const_iterator it = prefixes[node].next.find((unsigned char)path[i]);
+        if (it == prefixes[node].next.end())
+            break;
+        node = it->second;
+        if (prefixes[node].location >= 0)
+            prefix = prefixes[node].location;
+    }
+
+    // Every pattern path ends with is on this walk; the last declared one wins
+    node = 0;
+    for (size_t i = path.size(); i > 0; --i)
+    {
+        std::map<unsigned char, int>::const_iterator it = suffixes[node].next.find((unsigned char)path[i - 1]);
+        if (it == suffixes[node].next.end())
+            break;
+        node = it->second;
+        if (suffixes[node].location > suffix)
+            suffix = suffixes[node].location;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef LOCATIONROUTER_HPP
+#define LOCATIONROUTER_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct Location;
+
+// The locations of one server compiled into two tries when the config is
+// loaded, so that routing a request costs one walk over its path whatever the
+// number of locations: prefixes are read forwards from the start of the path,
+// "*ext" patterns backwards from its end.
+class LocationRouter
+{
+public:
+    void compile(const std::vector<Location> &locations);
+
+    // Indexes in locations of the longest prefix of path (the first declared
+    // one among equals) and of the last declared "*ext" pattern path ends
+    // with; -1 when nothing matches
+    void match(const std::string &path, int &prefix, int &suffix) const;
+
+private:
+    struct Node
+    {
+        std::map<unsigned char, int> next;
+        int location; // -1 when no pattern ends here
+
+        Node() : location(-1) {}
+    };
+
+    std::vector<Node> prefixes; // node 0 is the root
+    std::vector<Node> suffixes; // patterns without their '*', stored last character first
+
+    static int child(std::vector<Node> &trie, int node, unsigned char c);
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "MimeTypes.hpp"
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+// Longer extensions are not looked up: nothing registered is that long
+static const size_t MAX_EXTENSION = 32;
+
+static const char *BUILTIN[][2] = {
+    {"text/html", "html"}, {"text/html", "htm"}, {"text/css", "css"},
+    {"application/javascript", "js"}, {"application/javascript", "mjs"},
+    {"application/json", "json"}, {"application/xml", "xml"}, {"text/plain", "txt"},
+    {"text/csv", "csv"}, {"text/markdown", "md"},
+    {"image/png", "png"}, {"image/jpeg", "jpg"}, {"image/jpeg", "jpeg"}, {"image/gif", "gif"},
+    {"image/x-icon", "ico"}, {"image/svg+xml", "svg"}, {"image/webp", "webp"}, {"image/avif", "avif"},
+    {"font/woff", "woff"}, {"font/woff2", "woff2"}, {"font/ttf", "ttf"}, {"font/otf", "otf"},
+    {"video/mp4", "mp4"}, {"video/webm", "webm"}, {"audio/mpeg", "mp3"}, {"audio/ogg", "ogg"},
+    {"audio/wav", "wav"}, {"application/pdf", "pdf"}, {"application/zip", "zip"},
+    {"application/gzip", "gz"}, {"application/wasm", "wasm"},
+    {0, 0}};
+
+static size_t hashExtension(const char *ext, size_t length)
+{
+    size_t h = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < length; ++i)
+        h = (h ^ (unsigned char)ext[i]) * 16777619u;
+    return h;
+}
+
+MimeTypes::MimeTypes() : used(0), fallback("application/octet-stream")
+{
+    Slot empty;
+    empty.used = false;
+    slots.assign(64, empty);
+    for (size_t i = 0; BUILTIN[i][0]; ++i)
+        add(BUILTIN[i][0], BUILTIN[i][1]);
+}
+
+void MimeTypes::grow()
+{
+    std::vector<Slot> old;
+    old.swap(slots);
+    Slot empty;
+    empty.used = false;
+    slots.assign(old.size() * 2, empty);
+    used = 0;
+    for (size_t i = 0; i < old.size(); ++i)
+    {
+        if (old[i].used)
+            add(old[i].type, old[i].extension);
+    }
+}
+
+void MimeTypes::add(const std::string &type, const std::string &extension)
+{
+    std::string ext = extension;
+    for (size_t i = 0; i < ext.size(); ++i)
+        ext[i] = (char)std::tolower((unsigned char)ext[i]);
+    if (ext.empty() || ext.size() > MAX_EXTENSION)
+        return;
+    if ((used + 1) * 2 > slots.size())
+        grow();
+    size_t mask = slots.size() - 1;
+    size_t i = hashExtension(ext.data(), ext.size()) & mask;
+    while (slots[i].used && slots[i].extension != ext)
+        i = (i + 1) & mask;
+    if (!slots[i].used)
+        used++;
+    slots[i].extension = ext;
+    slots[i].type = type; // the last declaration of an extension wins
+    slots[i].used = true;
+}
+
+void MimeTypes::addEntry(const std::string &line)
+{
+    std::istringstream iss(line);
+    std::string type;
+    std::string word;
+    while (iss >> word)
+    {
+        bool last = word[word.size() - 1] == ';';
+        if (last)
+            word.erase(word.size() - 1);
+        if (word == "types" || word == "{" || word == "}")
+            continue;
+        if (type.empty())
+            type = word;
+        else if (!word.empty())
+            add(type, word);
+        if (last)
+            type.clear();
+    }
+}
+
+bool MimeTypes::load(const std::string &file)
+{
+    std::ifstream in(file.c_str());
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        addEntry(line);
+    }
+    return true;
+}
+
+void MimeTypes::setDefault(const std::string &type)
+{
+    fallback = type;
+}
+
+const std::string &MimeTypes::defaultType() const
+{
+    return fallback;
+}
+
+const std::string &MimeTypes::lookup(const std::string &path) const
+{
+    size_t dot = path.find_last_of("./");
+    if (dot == std::string::npos || path[dot] != '.')
+        return fallback;
+    size_t length = path.size() - dot - 1;
+    if (length == 0 || length > MAX_EXTENSION)
+        return fallback;
+    char ext[MAX_EXTENSION];
+    for (size_t i = 0; i < length; ++i)
+        ext[i] = (char)std::tolower((unsigned char)path[dot + 1 + i]);
+
+    size_t mask = slots.size() - 1;
+    size_t i = hashExtension(ext, length) & mask;
+    while (slots[i].used)
+    {
+        if (slots[i].extension.size() == length && slots[i].extension.compare(0, length, ext, length) == 0)
+            return slots[i].type;
+        i = (i + 1) & mask;
+    }
+    return fallback;
+}
@@ -0,0 +1,45 @@
+#ifndef MIMETYPES_HPP
+#define MIMETYPES_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Content-Type of static files by extension, in an open addressing hash
+// table filled when the config is loaded: the common web types are built in,
+// then `types { }` blocks and `include` files add to them or override them.
+class MimeTypes
+{
+public:
+    MimeTypes();
+
+    // extension without its dot, any case
+    void add(const std::string &type, const std::string &extension);
+    // Reads a types file, nginx ("types { text/html html htm; }") or
+    // Apache (/etc/mime.types) style; false when it cannot be opened
+    bool load(const std::string &file);
+    // Adds "type ext ext ...;" (one entry of a types block or file)
+    void addEntry(const std::string &line);
+    void setDefault(const std::string &type);
+    const std::string &defaultType() const;
+
+    // Type of path from its extension, the default type when it has none or
+    // an unknown one. No allocation: the string lives in the table.
+    const std::string &lookup(const std::string &path) const;
+
+private:
+    struct Slot
+    {
+        std::string extension;
+        std::string type;
+        bool used;
+    };
+
+    std::vector<Slot> slots; // size a power of two, at most half full
+    size_t used;
+    std::string fallback;
+
+    void grow();
+};
+
+#endif
@@ -0,0 +1,180 @@
+#include "VirtualHosts.hpp"
+#include "ConfigStructs.hpp"
+#include <cctype>
+#include <sstream>
+
+// Longest host name (RFC 1035); longer Host values go to the default server
+static const size_t MAX_HOST = 255;
+
+static size_t hashName(size_t address, int kind, const char *name, size_t length)
+{
+    size_t h = 2166136261u; // FNV-1a
+    h = (h ^ address) * 16777619u;
+    h = (h ^ (size_t)kind) * 16777619u;
+    for (size_t i = 0; i < length; ++i)
+        h = (h ^ (unsigned char)name[i]) * 16777619u;
+    return h;
+}
+
+static std::string lowercase(std::string name)
+{
+    for (size_t i = 0; i < name.size(); ++i)
+        name[i] = (char)std::tolower((unsigned char)name[i]);
+    return name;
+}
+
+VirtualHosts::VirtualHosts() : used(0) {}
+
+void VirtualHosts::compile(const std::vector<Server> &servers)
+{
+    addrs.clear();
+    slots.assign(16, Slot());
+    for (size_t i = 0; i < slots.size(); ++i)
+        slots[i].used = false;
+    used = 0;
+
+    std::vector<bool> explicitDefault;
+    for (size_t s = 0; s < servers.size(); ++s)
+    {
+        const Server &server = servers[s];
+        size_t a = 0;
+        while (a < addrs.size() && !(addrs[a].host == server.host && addrs[a].port == server.listen))
+            a++;
+        if (a == addrs.size())
+        {
+            Address address;
+            address.host = server.host;
+            address.port = server.listen;
+            address.defaultServer = s;
+            addrs.push_back(address);
+            explicitDefault.push_back(false);
+        }
+        if (server.default_server && !explicitDefault[a])
+        {
+            addrs[a].defaultServer = s;
+            explicitDefault[a] = true;
+        }
+
+        std::istringstream names(server.server_name);
+        std::string name;
+        while (names >> name)
+        {
+            name = lowercase(name);
+            if (name.size() > 1 && name[0] == '.')
+            {
+                // ".example.com" is both "example.com" and "*.example.com"
+                add(a, EXACT, name.substr(1), s);
+                add(a, LEADING, name, s);
+            }
+            else if (name.size() > 2 && name.compare(0, 2, "*.") == 0)
+                add(a, LEADING, name.substr(1), s);
+            else if (name.size() > 2 && name.compare(name.size() - 2, 2, ".*") == 0)
+                add(a, TRAILING, name.substr(0, name.size() - 1), s);
+            else
+                add(a, EXACT, name, s);
+        }
+    }
+}
+
+void VirtualHosts::grow()
+{
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(old.size() * 2, Slot());
+    for (size_t i = 0; i < slots.size(); ++i)
+        slots[i].used = false;
+    used = 0;
+    for (size_t i = 0; i < old.size(); ++i)
+    {
+        if (old[i].used)
+            add(old[i].address, old[i].kind, old[i].name, old[i].server);
+    }
+}
+
+// The first server declaring a name on an address keeps it, as in nginx
+void VirtualHosts::add(size_t address, int kind, const std::string &name, size_t server)
+{
+    if (find(address, kind, name.data(), name.size()))
+        return;
+    if ((used + 1) * 2 > slots.size())
+        grow();
+    size_t mask = slots.size() - 1;
+    size_t i = hashName(address, kind, name.data(), name.size()) & mask;
+    while (slots[i].used)
+        i = (i + 1) & mask;
+    slots[i].name = name;
+    slots[i].address = address;
+    slots[i].kind = kind;
+    slots[i].server = server;
+    slots[i].used = true;
+    used++;
+}
+
+const VirtualHosts::Slot *VirtualHosts::find(size_t address, int kind, const char *name, size_t length) const
+{
+    if (slots.empty())
+        return 0;
+    size_t mask = slots.size() - 1;
+    size_t i = hashName(address, kind, name, length) & mask;
+    while (slots[i].used)
+    {
+        const Slot &slot = slots[i];
+        if (slot.address == address && slot.kind == kind && slot.name.size() == length &&
+            slot.name.compare(0, length, name, length) == 0)
+            return &slot;
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+const std::vector<VirtualHosts::Address> &VirtualHosts::addresses() const
+{
+    return addrs;
+}
+
+size_t VirtualHosts::resolve(size_t address, const char *host, size_t length) const
+{
+    size_t fallback = address < addrs.size() ? addrs[address].defaultServer : 0;
+    if (!host)
+        return fallback;
+
+    // Host is "name[:port]" or "[v6]:port", any case, maybe with a final dot
+    char name[MAX_HOST];
+    size_t n = 0;
+    size_t end = length;
+    if (length > 0 && host[0] == '[')
+    {
+        for (end = 0; end < length && host[end] != ']'; ++end)
+            ;
+        if (end < length)
+            end++;
+    }
+    else
+    {
+        for (end = 0; end < length && host[end] != ':'; ++end)
+            ;
+    }
+    if (end > 0 && host[end - 1] == '.')
+        end--;
+    if (end == 0 || end > MAX_HOST)
+        return fallback;
+    for (n = 0; n < end; ++n)
+        name[n] = (char)std::tolower((unsigned char)host[n]);
+
+    const Slot *slot = find(address, EXACT, name, n);
+    if (slot)
+        return slot->server;
+    // Longest "*.suffix" first: suffixes from the leftmost dot on
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (name[i] == '.' && (slot = find(address, LEADING, name + i, n - i)))
+            return slot->server;
+    }
+    // Longest "prefix.*" first: prefixes up to the rightmost dot
+    for (size_t i = n; i > 0; --i)
+    {
+        if (name[i - 1] == '.' && (slot = find(address, TRAILING, name, i)))
+            return slot->server;
+    }
+    return fallback;
+}
@@ -0,0 +1,61 @@
+#ifndef VIRTUALHOSTS_HPP
+#define VIRTUALHOSTS_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct Server;
+
+// Which server answers a request: servers sharing a host:port share one
+// listening socket, and the Host header picks one of them through a hash
+// table keyed by (address, name), built when the config is loaded. Names are
+// matched as nginx does: exact name first, then the longest "*.example.com",
+// then the longest "www.example.*", and the default server of the address
+// when nothing matches (the one marked default_server, else the first one).
+class VirtualHosts
+{
+public:
+    struct Address
+    {
+        std::string host;
+        int port;
+        size_t defaultServer; // index into servers.servers
+    };
+
+    VirtualHosts();
+    void compile(const std::vector<Server> &servers);
+
+    // One listening socket per entry, in this order
+    const std::vector<Address> &addresses() const;
+    // Index of the server answering a request received on addresses()[address]
+    // with this Host header value (NULL when the request had none)
+    size_t resolve(size_t address, const char *host, size_t length) const;
+
+private:
+    enum Kind
+    {
+        EXACT,
+        LEADING, // "*.example.com", stored as ".example.com"
+        TRAILING // "www.example.*", stored as "www.example."
+    };
+
+    struct Slot
+    {
+        std::string name;
+        size_t address;
+        int kind;
+        size_t server;
+        bool used;
+    };
+
+    std::vector<Address> addrs;
+    std::vector<Slot> slots; // open addressing, size a power of two
+    size_t used;
+
+    void add(size_t address, int kind, const std::string &name, size_t server);
+    const Slot *find(size_t address, int kind, const char *name, size_t length) const;
+    void grow();
+};
+
+#endif
@@ -12,32 +12,160 @@
 #include <csignal>
 #include <ctime>
 
-// Helper to convert map to envp
-static char **createEnv(const std::map<std::string, std::string> &envMap)
+// envp built straight from the request's header table. Runs twice: once to size
+// the strings (block == NULL), once to write them, so the whole environment
+// is two allocations however many headers there are.
+struct EnvWriter
 {
-    char **env = new char *[envMap.size() + 1];
-    int i = 0;
-    for (std::map<std::string, std::string>::const_iterator it = envMap.begin(); it != envMap.end(); ++it)
+    char *block;
+    char **vars;
+    size_t size;
+    size_t count;
+};
+
+// Appends "<prefix><name>=<value>"; with a prefix the name is a header name
+// and becomes HTTP_UPPER_CASE
+static void envWrite(EnvWriter &w, const char *prefix, const char *name, size_t nameLen, const char *value, size_t valueLen)
+{
+    size_t prefixLen = ft_strlen(prefix);
+    if (w.block)
+    {
+        char *p = w.block + w.size;
+        w.vars[w.count] = p;
+        for (size_t i = 0; i < prefixLen; ++i)
+            *p++ = prefix[i];
+        for (size_t i = 0; i < nameLen; ++i)
+        {
+            char c = name[i];
+            if (prefixLen && c == '-')
+                c = '_';
+            else if (prefixLen && c >= 'a' && c <= 'z')
+                c -= 'a' - 'A';
+            *p++ = c;
+        }
+        *p++ = '=';
+        for (size_t i = 0; i < valueLen; ++i)
+            *p++ = value[i];
+        *p = '\0';
+    }
+    w.size += prefixLen + nameLen + valueLen + 2;
+    w.count++;
+}
+
+static void envAdd(EnvWriter &w, const char *name, const std::string &value)
+{
+    envWrite(w, "", name, ft_strlen(name), value.data(), value.size());
+}
+
+static void envAdd(EnvWriter &w, const char *name, const char *value)
+{
+    envWrite(w, "", name, ft_strlen(name), value, ft_strlen(value));
+}
+
+static bool isHeader(const HttpRequest &req, const HeaderSlice &h, const char *name)
+{
+    size_t len = ft_strlen(name);
+    return h.nameLen == len && ft_strncmp(req.data(h.name), name, len) == 0;
+}
+
+static bool repeatedLater(const HttpRequest &req, size_t index)
+{
+    const HeaderSlice &h = req.headers[index];
+    for (size_t i = index + 1; i < req.headers.size(); ++i)
     {
-        std::string s = it->first + "=" + it->second;
-        env[i] = new char[s.size() + 1];
-        ft_strcpy(env[i], s.c_str());
-        i++;
+        const HeaderSlice &o = req.headers[i];
+        if (o.nameLen == h.nameLen && ft_strncmp(req.data(o.name), req.data(h.name), h.nameLen) == 0)
+            return true;
     }
-    env[i] = NULL;
-    return env;
+    return false;
 }
 
-CgiSession CgiHandler::startCgi(const std::string &scriptPath, const std::string &method, const std::string &query, const std::string &body, const std::map<std::string, std::string> &headers, int clientFd)
+static void fillEnv(EnvWriter &w, const std::string &scriptPath, const HttpRequest &req, const char *contentLength)
+{
+    envAdd(w, "REQUEST_METHOD", req.method);
+    envAdd(w, "QUERY_STRING", req.query);
+    // The body the script reads is the de-chunked one, whatever the client sent
+    envAdd(w, "CONTENT_LENGTH", contentLength);
+    const HeaderSlice *type = req.header("content-type");
+    envWrite(w, "", "CONTENT_TYPE", 12, type ? req.data(type->value) : "", type ? type->valueLen : 0);
+    envAdd(w, "SCRIPT_FILENAME", scriptPath);
+    envAdd(w, "REDIRECT_STATUS", "200"); // Needed for PHP-CGI
+    envAdd(w, "SERVER_PROTOCOL", "HTTP/1.1");
+    envAdd(w, "GATEWAY_INTERFACE", "CGI/1.1");
+    envAdd(w, "PATH_INFO", scriptPath);
+    envAdd(w, "REQUEST_URI", scriptPath);
+    envAdd(w, "SCRIPT_NAME", scriptPath);
+
+    // Pass HTTP headers as HTTP_ variables
+    for (size_t i = 0; i < req.headers.size(); ++i)
+    {
+        const HeaderSlice &h = req.headers[i];
+        // A repeated header only keeps its last value
+        if (repeatedLater(req, i))
+            continue;
+        // Chunked framing is gone by now: announce the real length instead
+        if (req.chunked && (isHeader(req, h, "transfer-encoding") || isHeader(req, h, "content-length")))
+            continue;
+        envWrite(w, "HTTP_", req.data(h.name), h.nameLen, req.data(h.value), h.valueLen);
+    }
+    if (req.chunked)
+        envWrite(w, "HTTP_", "content-length", 14, contentLength, ft_strlen(contentLength));
+}
+
+static char **createEnv(const std::string &scriptPath, const HttpRequest &req)
+{
+    char contentLength[24];
+    size_t n = req.body.size();
+    int len = 0;
+    do
+    {
+        contentLength[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+    for (int i = 0; i < len / 2; ++i)
+    {
+        char c = contentLength[i];
+        contentLength[i] = contentLength[len - 1 - i];
+        contentLength[len - 1 - i] = c;
+    }
+    contentLength[len] = '\0';
+
+    EnvWriter w = {0, 0, 0, 0};
+    fillEnv(w, scriptPath, req, contentLength);
+    w.block = new char[w.size];
+    w.vars = new char *[w.count + 1];
+    w.size = 0;
+    w.count = 0;
+    fillEnv(w, scriptPath, req, contentLength);
+    w.vars[w.count] = NULL;
+    return w.vars;
+}
+
+// vars[0] is the start of the string block
+static void freeEnv(char **env)
+{
+    delete[] env[0];
+    delete[] env;
+}
+
+CgiSession CgiHandler::startCgi(const std::string &scriptPath, const HttpRequest &request, int clientFd)
 {
     CgiSession session;
     session.clientFd = clientFd;
     session.pid = -1;
     session.pipeOut = -1;
     session.startTime = time(NULL);
+    session.keepAlive = false;
+    session.gzip = false;
+    session.headOnly = false;
+    session.ioTag = 0;
 
-    // Use a temporary file for the request body to avoid pipe deadlocks with large bodies
+    // Use a temporary file for the request body to avoid pipe deadlocks with large bodies.
+    // The client fd is unique in the process while the request is alive, so workers never collide.
     char temp_path[256];
+    std::ostringstream tempName;
+    tempName << "/tmp/webserv_temp_" << getpid() << "_" << clientFd;
+    ft_strcpy(temp_path, tempName.str().c_str());
     int fdIn = ft_file_open_temp(temp_path);
     if (fdIn < 0)
     {
@@ -45,6 +173,7 @@ CgiSession CgiHandler::startCgi(const std::string &scriptPath, const std::string
         return session;
     }
 
+    const std::string &body = request.body;
     if (!body.empty())
     {
         const char *ptr = body.c_str();
@@ -69,15 +198,32 @@ CgiSession CgiHandler::startCgi(const std::string &scriptPath, const std::string
         }
     }
     ft_file_close(fdIn);
-    fdIn = open("/tmp/webserv_temp", O_RDONLY);
+    fdIn = open(temp_path, O_RDONLY | O_CLOEXEC);
+    // The open descriptor keeps the data alive for the child; the name is no longer needed
+    unlink(temp_path);
     if (fdIn < 0)
     {
         return session;
     }
 
+    // Determine interpreter
+    std::string interpreter = "/usr/bin/python3"; // Default
+    if (scriptPath.find(".php") != std::string::npos)
+    {
+        interpreter = "/usr/bin/php-cgi";
+    }
+
+    // Everything the child needs is built before fork(): with worker threads running,
+    // the child must not allocate (another thread may hold the allocator lock).
+    char **envp = createEnv(scriptPath, request);
+    const char *argv[] = {interpreter.c_str(), scriptPath.c_str(), NULL};
+
+    // Close-on-exec from the start: a CGI forked meanwhile by another worker must
+    // not inherit the write end, or this one never sees EOF (dup2 clears the flag on stdout)
     int pipe_out[2];
-    if (pipe(pipe_out) < 0)
+    if (pipe2(pipe_out, O_CLOEXEC) < 0)
     {
+        freeEnv(envp);
         ft_file_close(fdIn);
         return session;
     }
@@ -85,6 +231,7 @@ CgiSession CgiHandler::startCgi(const std::string &scriptPath, const std::string
     pid_t pid = fork();
     if (pid < 0)
     {
+        freeEnv(envp);
         ft_file_close(fdIn);
         close(pipe_out[0]);
         close(pipe_out[1]);
@@ -99,66 +246,21 @@ CgiSession CgiHandler::startCgi(const std::string &scriptPath, const std::string
 
         close(pipe_out[0]);
         close(pipe_out[1]);
-        // fclose(tmpIn); // Not strictly necessary as we exec, but good practice if we weren't
-
-        // Prepare environment
-        std::map<std::string, std::string> env;
-        env["REQUEST_METHOD"] = method;
-        env["QUERY_STRING"] = query;
-        env["CONTENT_LENGTH"] = headers.count("content-length") ? headers.at("content-length") : "0";
-        env["CONTENT_TYPE"] = headers.count("content-type") ? headers.at("content-type") : "";
-        env["SCRIPT_FILENAME"] = scriptPath;
-        env["REDIRECT_STATUS"] = "200"; // Needed for PHP-CGI
-        env["SERVER_PROTOCOL"] = "HTTP/1.1";
-        env["GATEWAY_INTERFACE"] = "CGI/1.1";
-        env["PATH_INFO"] = scriptPath;
-        env["REQUEST_URI"] = scriptPath; // Add REQUEST_URI
-        env["SCRIPT_NAME"] = scriptPath; // Add SCRIPT_NAME
-
-        // Pass HTTP headers as HTTP_ variables
-        for (std::map<std::string, std::string>::const_iterator it = headers.begin(); it != headers.end(); ++it)
-        {
-            std::string key = it->first;
-            std::string val = it->second;
-
-            // Convert key to uppercase and replace - with _
-            std::string envKey = "HTTP_";
-            for (size_t i = 0; i < key.size(); ++i)
-            {
-                char c = key[i];
-                if (c == '-')
-                    c = '_';
-                else
-                    c = toupper(c);
-                envKey += c;
-            }
-            env[envKey] = val;
-        }
-
-        char **envp = createEnv(env);
-
-        // Determine interpreter
-        std::string interpreter = "/usr/bin/python3"; // Default
-        if (scriptPath.find(".php") != std::string::npos)
-        {
-            interpreter = "/usr/bin/php-cgi";
-        }
-
-        const char *argv[] = {interpreter.c_str(), scriptPath.c_str(), NULL};
+        // An ignored SIGPIPE survives execve(): give the script the default back
+        signal(SIGPIPE, SIG_DFL);
 
         execve(argv[0], (char *const *)argv, envp);
         // If execve returns, it failed - write error to pipe
-        std::cerr << "CGI execve failed " << std::endl;
+        const char *failed = "CGI execve failed\n";
+        write(STDERR_FILENO, failed, ft_strlen(failed));
         const char *error_msg = "Status: 500 Internal Server Error\r\n\r\n";
-        write(pipe_out[1], error_msg, 36);
-        close(pipe_out[1]);
-        close(pipe_out[0]);
-        ft_file_close(fdIn);
-        // Child process ends here - return ends the forked child process
-        exit(1);
+        write(STDOUT_FILENO, error_msg, ft_strlen(error_msg));
+        // _exit: skip atexit handlers and static destructors that belong to the server
+        _exit(1);
     }
 
     // Parent process
+    freeEnv(envp);
     ft_file_close(fdIn);
     close(pipe_out[1]); // Close write end
 
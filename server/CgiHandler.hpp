@@ -2,9 +2,10 @@
 #define CGIHANDLER_HPP
 
 #include <string>
-#include <map>
 #include <sys/types.h>
 #include "../parsing_validation/ConfigStructs.hpp"
+#include "../utils/TimerWheel.hpp"
+#include "../http/RequestParser.hpp"
 
 #include <ctime>
 
@@ -16,12 +17,16 @@ struct CgiSession
     std::string responseBuffer;
     time_t startTime;
     bool keepAlive;
+    bool gzip;      // the output may be compressed for the client
+    bool headOnly;  // HEAD request: the client gets the headers only
+    unsigned ioTag; // generation tag for io_uring completions on pipeOut
+    TimerNode timer; // execution deadline
 };
 
 class CgiHandler
 {
 public:
-    static CgiSession startCgi(const std::string &scriptPath, const std::string &method, const std::string &query, const std::string &body, const std::map<std::string, std::string> &headers, int clientFd);
+    static CgiSession startCgi(const std::string &scriptPath, const HttpRequest &request, int clientFd);
     // executeCgi removed/deprecated to enforce non-blocking rule
 };
 
@@ -0,0 +1,364 @@
+#include "IoUring.hpp"
+#include "../utils/Utils.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+// Buffer group id shared by every buffer-select request
+static const unsigned short BUF_GROUP = 0;
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned submit, unsigned minComplete, unsigned flags,
+                              void *arg, size_t argSize)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, submit, minComplete, flags, arg, argSize);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nrArgs)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs);
+}
+
+// Multishot recv needs Linux 6.0; there is no feature bit for it, so check the release.
+static bool kernelAtLeast(int major, int minor)
+{
+    struct utsname u;
+    if (uname(&u) != 0)
+        return false;
+    char *end = 0;
+    long maj = ft_strtol(u.release, &end, 10);
+    long min = 0;
+    if (end && *end == '.')
+        min = ft_strtol(end + 1, &end, 10);
+    return maj > major || (maj == major && min >= minor);
+}
+
+IoUring::IoUring()
+    : ringFd(-1), sqEntries(0), cqEntries(0),
+      sqRing(MAP_FAILED), sqRingSize(0), cqRing(MAP_FAILED), cqRingSize(0),
+      sqes((struct io_uring_sqe *)MAP_FAILED), sqesSize(0),
+      sqHead(0), sqTail(0), sqMask(0), sqArray(0), sqLocalTail(0), toSubmit(0),
+      cqHead(0), cqTail(0), cqMask(0), cqes(0),
+      bufRing((struct io_uring_buf_ring *)MAP_FAILED), bufRingSize(0), bufPool(0),
+      bufCount(0), bufSize(0), bufTail(0)
+{
+}
+
+IoUring::~IoUring()
+{
+    release();
+}
+
+void IoUring::release()
+{
+    // Closing the ring cancels everything still in flight
+    if (ringFd >= 0)
+        close(ringFd);
+    ringFd = -1;
+    if (sqes != MAP_FAILED)
+        munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+        munmap(sqRing, sqRingSize);
+    if (bufRing != MAP_FAILED)
+        munmap(bufRing, bufRingSize);
+    sqes = (struct io_uring_sqe *)MAP_FAILED;
+    sqRing = cqRing = MAP_FAILED;
+    bufRing = (struct io_uring_buf_ring *)MAP_FAILED;
+    delete[] bufPool;
+    bufPool = 0;
+}
+
+bool IoUring::init(unsigned entries, unsigned bufferCount, unsigned bufferSize)
+{
+    if (!kernelAtLeast(6, 0))
+        return false;
+
+    struct io_uring_params p;
+    ft_memset(&p, 0, sizeof(p));
+    // Multishot requests produce many completions per submission: give the CQ room
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = entries * 8;
+    ringFd = sys_io_uring_setup(entries, &p);
+    if (ringFd < 0)
+        return false;
+    if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_SINGLE_MMAP) ||
+        !(p.features & IORING_FEAT_NODROP))
+    {
+        release();
+        return false;
+    }
+
+    sqEntries = p.sq_entries;
+    cqEntries = p.cq_entries;
+    sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (cqRingSize > sqRingSize)
+        sqRingSize = cqRingSize;
+    cqRingSize = sqRingSize;
+
+    sqRing = mmap(0, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+    {
+        release();
+        return false;
+    }
+    cqRing = sqRing; // IORING_FEAT_SINGLE_MMAP
+
+    sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = (struct io_uring_sqe *)mmap(0, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                       ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        release();
+        return false;
+    }
+
+    char *sq = (char *)sqRing;
+    sqHead = (unsigned *)(sq + p.sq_off.head);
+    sqTail = (unsigned *)(sq + p.sq_off.tail);
+    sqMask = (unsigned *)(sq + p.sq_off.ring_mask);
+    sqArray = (unsigned *)(sq + p.sq_off.array);
+    sqLocalTail = *sqTail;
+
+    char *cq = (char *)cqRing;
+    cqHead = (unsigned *)(cq + p.cq_off.head);
+    cqTail = (unsigned *)(cq + p.cq_off.tail);
+    cqMask = (unsigned *)(cq + p.cq_off.ring_mask);
+    cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    // Provided buffer ring (Linux 5.19+): the kernel picks a free buffer per completion
+    bufCount = bufferCount;
+    bufSize = bufferSize;
+    bufRingSize = bufCount * sizeof(struct io_uring_buf);
+    bufRing = (struct io_uring_buf_ring *)mmap(0, bufRingSize, PROT_READ | PROT_WRITE,
+                                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufRing == MAP_FAILED)
+    {
+        release();
+        return false;
+    }
+    bufPool = new char[(size_t)bufCount * bufSize];
+
+    struct io_uring_buf_reg reg;
+    ft_memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long)bufRing;
+    reg.ring_entries = bufCount;
+    reg.bgid = BUF_GROUP;
+    if (sys_io_uring_register(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        release();
+        return false;
+    }
+    bufTail = 0;
+    for (unsigned i = 0; i < bufCount; ++i)
+        recycleBuffer(i);
+    return true;
+}
+
+struct io_uring_sqe *IoUring::getSqe()
+{
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (sqLocalTail - head >= sqEntries)
+    {
+        // SQ full: hand what we have to the kernel first
+        if (enter(toSubmit, 0, 0, 0, 0) < 0)
+            return 0;
+        head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqLocalTail - head >= sqEntries)
+            return 0;
+    }
+    unsigned idx = sqLocalTail & *sqMask;
+    struct io_uring_sqe *sqe = &sqes[idx];
+    ft_memset(sqe, 0, sizeof(*sqe));
+    sqArray[idx] = idx;
+    sqLocalTail++;
+    toSubmit++;
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+int IoUring::enter(unsigned submit, unsigned minComplete, unsigned flags, void *arg, size_t argSize)
+{
+    int ret = sys_io_uring_enter(ringFd, submit, minComplete, flags, arg, argSize);
+    if (ret < 0)
+        return -errno;
+    if ((unsigned)ret >= toSubmit)
+        toSubmit = 0;
+    else
+        toSubmit -= ret;
+    return ret;
+}
+
+bool IoUring::acceptMultishot(int listenFd, uint64_t data)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = data;
+    return true;
+}
+
+bool IoUring::recvMultishot(int fd, uint64_t data)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUF_GROUP;
+    sqe->user_data = data;
+    return true;
+}
+
+bool IoUring::readSelect(int fd, uint64_t data)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = (uint64_t)-1; // current position (pipes have none)
+    sqe->len = bufSize;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUF_GROUP;
+    sqe->user_data = data;
+    return true;
+}
+
+bool IoUring::sendMsg(int fd, const struct msghdr *msg, uint64_t data, bool linkNext)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    if (linkNext)
+    {
+        // MSG_WAITALL makes a short send count as a failure, so the linked
+        // request only runs once every byte is out (and is cancelled otherwise)
+        sqe->msg_flags |= MSG_WAITALL;
+        sqe->flags = IOSQE_IO_LINK;
+    }
+    sqe->user_data = data;
+    return true;
+}
+
+bool IoUring::splice(int pipeFd, int fd, unsigned len, uint64_t data)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_SPLICE;
+    sqe->splice_fd_in = pipeFd;
+    sqe->splice_off_in = (uint64_t)-1; // pipes have no offset
+    sqe->fd = fd;
+    sqe->off = (uint64_t)-1;
+    sqe->len = len;
+    sqe->splice_flags = SPLICE_F_MOVE;
+    sqe->user_data = data;
+    return true;
+}
+
+bool IoUring::closeFd(int fd, uint64_t data)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->user_data = data;
+    return true;
+}
+
+bool IoUring::cancelFd(int fd, uint64_t data)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = fd;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = data;
+    return true;
+}
+
+bool IoUring::cancelData(uint64_t target, uint64_t data)
+{
+    struct io_uring_sqe *sqe = getSqe();
+    if (!sqe)
+        return false;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = target;
+    sqe->user_data = data;
+    return true;
+}
+
+int IoUring::submitAndWait(int timeoutMs)
+{
+    struct __kernel_timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = (long long)(timeoutMs % 1000) * 1000000;
+
+    struct io_uring_getevents_arg arg;
+    ft_memset(&arg, 0, sizeof(arg));
+    arg.sigmask = 0;
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = (unsigned long)&ts;
+
+    int ret = enter(toSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (ret == -ETIME)
+        return 0;
+    return ret < 0 ? ret : 0;
+}
+
+struct io_uring_cqe *IoUring::peek()
+{
+    unsigned head = *cqHead;
+    if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+        return 0;
+    return &cqes[head & *cqMask];
+}
+
+void IoUring::seen()
+{
+    __atomic_store_n(cqHead, *cqHead + 1, __ATOMIC_RELEASE);
+}
+
+const char *IoUring::bufferData(unsigned bid) const
+{
+    return bufPool + (size_t)bid * bufSize;
+}
+
+void IoUring::recycleBuffer(unsigned bid)
+{
+    // The entries start at offset 0 (the tail overlays the first entry's resv field).
+    // bufRing->bufs is not used: compiled as C++ the header's flex-array member lands at offset 8.
+    struct io_uring_buf *buf = (struct io_uring_buf *)bufRing + (bufTail & (bufCount - 1));
+    buf->addr = (unsigned long)(bufPool + (size_t)bid * bufSize);
+    buf->len = bufSize;
+    buf->bid = (unsigned short)bid;
+    bufTail++;
+    __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+}
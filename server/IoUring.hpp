@@ -0,0 +1,108 @@
+// Minimal io_uring wrapper (raw syscalls, no liburing) used by the io_uring event engine.
+// It owns the submission/completion rings and one provided-buffer ring that
+// multishot recv and CGI pipe reads pick their buffers from.
+#ifndef IO_URING_HPP
+#define IO_URING_HPP
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <cstddef>
+#include <stdint.h>
+
+// user_data layout: | type (8 bits) | tag (24 bits) | fd (32 bits) |
+// The tag changes every time an fd number is reused, so completions that
+// arrive after a connection was closed can be recognised and dropped.
+enum UringOpType
+{
+    URING_ACCEPT = 1,
+    URING_RECV,
+    URING_SEND,
+    URING_SPLICE,
+    URING_CLOSE,
+    URING_CANCEL,
+    URING_CGI_READ,
+    URING_INOTIFY
+};
+
+inline uint64_t uringData(int type, unsigned tag, int fd)
+{
+    return ((uint64_t)(type & 0xff) << 56) | ((uint64_t)(tag & 0xffffff) << 32) | (uint32_t)fd;
+}
+inline int uringType(uint64_t data) { return (int)(data >> 56); }
+inline unsigned uringTag(uint64_t data) { return (unsigned)((data >> 32) & 0xffffff); }
+inline int uringFd(uint64_t data) { return (int)(uint32_t)data; }
+
+class IoUring
+{
+public:
+    IoUring();
+    ~IoUring();
+
+    // Sets up the rings and the buffer pool. Returns false (and leaves the
+    // object unusable) when the kernel lacks anything the engine relies on:
+    // EXT_ARG waits, provided buffer rings and multishot accept/recv.
+    bool init(unsigned entries, unsigned bufferCount, unsigned bufferSize);
+
+    // Submission helpers; each returns false only when the SQ is full even after flushing it.
+    bool acceptMultishot(int listenFd, uint64_t data);
+    bool recvMultishot(int fd, uint64_t data);
+    bool readSelect(int fd, uint64_t data); // single read into a pool buffer
+    // msg (and its iovecs) must stay valid until the completion arrives
+    bool sendMsg(int fd, const struct msghdr *msg, uint64_t data, bool linkNext);
+    // Moves up to len bytes from the read end of a pipe to fd (file data without a user-space copy)
+    bool splice(int pipeFd, int fd, unsigned len, uint64_t data);
+    bool closeFd(int fd, uint64_t data);
+    bool cancelFd(int fd, uint64_t data); // cancels every request pending on fd
+    bool cancelData(uint64_t target, uint64_t data); // cancels the request tagged `target`
+
+    // Submits pending SQEs and waits up to timeoutMs for at least one completion.
+    // Returns 0 on success/timeout, -errno on failure (-EINTR on signal).
+    int submitAndWait(int timeoutMs);
+
+    // Completion iteration: peek() returns the next CQE or NULL, seen() consumes it.
+    struct io_uring_cqe *peek();
+    void seen();
+
+    const char *bufferData(unsigned bid) const;
+    void recycleBuffer(unsigned bid);
+
+private:
+    int ringFd;
+    unsigned sqEntries;
+    unsigned cqEntries;
+
+    void *sqRing;
+    size_t sqRingSize;
+    void *cqRing;
+    size_t cqRingSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned sqLocalTail;
+    unsigned toSubmit;
+
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+
+    struct io_uring_buf_ring *bufRing;
+    size_t bufRingSize;
+    char *bufPool;
+    unsigned bufCount;
+    unsigned bufSize;
+    unsigned short bufTail;
+
+    struct io_uring_sqe *getSqe();
+    int enter(unsigned submit, unsigned minComplete, unsigned flags, void *arg, size_t argSize);
+    void release();
+
+    IoUring(const IoUring &);
+    IoUring &operator=(const IoUring &);
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "Poller.hpp"
+#include "../utils/Utils.hpp"
+#include <unistd.h>
+#include <sys/time.h>
+
+Poller *Poller::create(const std::string &engine)
+{
+    if (engine == "select")
+        return new SelectPoller();
+
+    EpollPoller *ep = new EpollPoller();
+    if (ep->isOpen())
+        return ep;
+    delete ep;
+    ft_perror("epoll_create1: falling back to select");
+    return new SelectPoller();
+}
+
+// ===== select =====
+
+SelectPoller::SelectPoller()
+{
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+}
+
+bool SelectPoller::add(int fd, int events, bool edge)
+{
+    // select() cannot watch descriptors past FD_SETSIZE
+    if (fd < 0 || fd >= FD_SETSIZE)
+        return false;
+    fds.insert(fd);
+    return modify(fd, events, edge);
+}
+
+bool SelectPoller::modify(int fd, int events, bool edge)
+{
+    (void)edge; // select is always level-triggered
+    if (fd < 0 || fd >= FD_SETSIZE)
+        return false;
+    if (events & POLL_READ)
+        FD_SET(fd, &readSet);
+    else
+        FD_CLR(fd, &readSet);
+    if (events & POLL_WRITE)
+        FD_SET(fd, &writeSet);
+    else
+        FD_CLR(fd, &writeSet);
+    return true;
+}
+
+void SelectPoller::remove(int fd)
+{
+    if (fd < 0 || fd >= FD_SETSIZE)
+        return;
+    FD_CLR(fd, &readSet);
+    FD_CLR(fd, &writeSet);
+    fds.erase(fd);
+}
+
+int SelectPoller::wait(std::vector<PollEvent> &out, int timeoutMs)
+{
+    out.clear();
+    fd_set r = readSet;
+    fd_set w = writeSet;
+    int maxfd = fds.empty() ? -1 : *fds.rbegin();
+
+    timeval tv;
+    timeval *tvp = 0;
+    if (timeoutMs >= 0)
+    {
+        tv.tv_sec = timeoutMs / 1000;
+        tv.tv_usec = (timeoutMs % 1000) * 1000;
+        tvp = &tv;
+    }
+
+    int ready = select(maxfd + 1, &r, &w, NULL, tvp);
+    if (ready <= 0)
+        return ready;
+
+    for (std::set<int>::const_iterator it = fds.begin(); it != fds.end(); ++it)
+    {
+        int ev = 0;
+        if (FD_ISSET(*it, &r))
+            ev |= POLL_READ;
+        if (FD_ISSET(*it, &w))
+            ev |= POLL_WRITE;
+        if (ev)
+        {
+            PollEvent pe;
+            pe.fd = *it;
+            pe.events = ev;
+            out.push_back(pe);
+        }
+    }
+    return (int)out.size();
+}
+
+const char *SelectPoller::name() const
+{
+    return "select";
+}
+
+// ===== epoll =====
+
+EpollPoller::EpollPoller() : epfd(epoll_create1(EPOLL_CLOEXEC)), events(1024)
+{
+}
+
+EpollPoller::~EpollPoller()
+{
+    if (epfd >= 0)
+        close(epfd);
+}
+
+bool EpollPoller::isOpen() const
+{
+    return epfd >= 0;
+}
+
+static epoll_event makeEvent(int fd, int events, bool edge)
+{
+    epoll_event ev;
+    ft_memset(&ev, 0, sizeof(ev));
+    ev.data.fd = fd;
+    if (events & POLL_READ)
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    if (events & POLL_WRITE)
+        ev.events |= EPOLLOUT;
+    if (edge)
+        ev.events |= EPOLLET;
+    return ev;
+}
+
+bool EpollPoller::add(int fd, int events, bool edge)
+{
+    epoll_event ev = makeEvent(fd, events, edge);
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool EpollPoller::modify(int fd, int events, bool edge)
+{
+    epoll_event ev = makeEvent(fd, events, edge);
+    return epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EpollPoller::remove(int fd)
+{
+    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+int EpollPoller::wait(std::vector<PollEvent> &out, int timeoutMs)
+{
+    out.clear();
+    int n = epoll_wait(epfd, &events[0], (int)events.size(), timeoutMs);
+    if (n <= 0)
+        return n;
+
+    for (int i = 0; i < n; ++i)
+    {
+        PollEvent pe;
+        pe.fd = events[i].data.fd;
+        pe.events = 0;
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP))
+            pe.events |= POLL_READ;
+        if (events[i].events & EPOLLOUT)
+            pe.events |= POLL_WRITE;
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+            pe.events |= POLL_ERROR;
+        out.push_back(pe);
+    }
+    // A full batch means more events are probably waiting: grow for next time
+    if (n == (int)events.size())
+        events.resize(events.size() * 2);
+    return n;
+}
+
+const char *EpollPoller::name() const
+{
+    return "epoll";
+}
@@ -0,0 +1,83 @@
+// Strategy Pattern: Poller hides the readiness API (select or epoll) behind one interface
+// so the event loop in ServerMain does not care which kernel mechanism is used.
+#ifndef POLLER_HPP
+#define POLLER_HPP
+
+#include <string>
+#include <vector>
+#include <set>
+#include <sys/select.h>
+#include <sys/epoll.h>
+
+enum PollFlags
+{
+    POLL_READ = 1,
+    POLL_WRITE = 2,
+    POLL_ERROR = 4
+};
+
+struct PollEvent
+{
+    int fd;
+    int events; // combination of PollFlags
+};
+
+class Poller
+{
+public:
+    virtual ~Poller() {}
+
+    // Registers fd with the given interest. edge = true asks for edge-triggered
+    // notification (the caller then has to drain the fd until EAGAIN).
+    virtual bool add(int fd, int events, bool edge) = 0;
+    virtual bool modify(int fd, int events, bool edge) = 0;
+    virtual void remove(int fd) = 0;
+    // Waits up to timeoutMs (-1 = forever). Returns the number of events, 0 on timeout, -1 on error.
+    virtual int wait(std::vector<PollEvent> &out, int timeoutMs) = 0;
+    virtual const char *name() const = 0;
+
+    // Builds the engine named in the config ("epoll" or "select").
+    // Falls back to select when epoll is unavailable.
+    static Poller *create(const std::string &engine);
+};
+
+// Level-triggered select(): interest sets are kept between calls instead of
+// being rebuilt every iteration, but the kernel still scans every fd.
+class SelectPoller : public Poller
+{
+private:
+    fd_set readSet;
+    fd_set writeSet;
+    std::set<int> fds;
+
+public:
+    SelectPoller();
+    bool add(int fd, int events, bool edge);
+    bool modify(int fd, int events, bool edge);
+    void remove(int fd);
+    int wait(std::vector<PollEvent> &out, int timeoutMs);
+    const char *name() const;
+};
+
+// epoll(): persistent interest registration, O(ready) per wakeup.
+class EpollPoller : public Poller
+{
+private:
+    int epfd;
+    std::vector<struct epoll_event> events;
+
+    EpollPoller(const EpollPoller &);
+    EpollPoller &operator=(const EpollPoller &);
+
+public:
+    EpollPoller();
+    ~EpollPoller();
+    bool isOpen() const;
+    bool add(int fd, int events, bool edge);
+    bool modify(int fd, int events, bool edge);
+    void remove(int fd);
+    int wait(std::vector<PollEvent> &out, int timeoutMs);
+    const char *name() const;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "ByteScan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+# define BYTE_SCAN_X86 1
+# include <immintrin.h>
+# include <cpuid.h>
+#endif
+
+static const char *findByteScalar(const char *s, int c, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (s[i] == (char)c)
+            return s + i;
+    }
+    return 0;
+}
+
+static void toLowerScalar(char *s, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (s[i] >= 'A' && s[i] <= 'Z')
+            s[i] += 'a' - 'A';
+    }
+}
+
+#ifdef BYTE_SCAN_X86
+
+// 16 bytes per step: compare against the broadcast byte, the movemask bit gives the position
+__attribute__((target("sse2")))
+static const char *findByteSse2(const char *s, int c, size_t n)
+{
+    const __m128i needle = _mm_set1_epi8((char)c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if (mask)
+            return s + i + __builtin_ctz(mask);
+    }
+    return findByteScalar(s + i, c, n - i);
+}
+
+// Bytes in ['A', 'Z'] get bit 0x20 set. The compares are signed, so bytes
+// >= 0x80 read as negative and are never touched.
+__attribute__((target("sse2")))
+static void toLowerSse2(char *s, size_t n)
+{
+    const __m128i below = _mm_set1_epi8('A' - 1);
+    const __m128i above = _mm_set1_epi8('Z' + 1);
+    const __m128i bit = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, below), _mm_cmplt_epi8(chunk, above));
+        _mm_storeu_si128((__m128i *)(s + i), _mm_or_si128(chunk, _mm_and_si128(upper, bit)));
+    }
+    toLowerScalar(s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static const char *findByteAvx2(const char *s, int c, size_t n)
+{
+    const __m256i needle = _mm256_set1_epi8((char)c);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(s + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+        if (mask)
+            return s + i + __builtin_ctz(mask);
+    }
+    // The 16-byte step is repeated here rather than calling the SSE2 kernel:
+    // mixing legacy SSE code with dirty YMM registers costs a state transition
+    if (i + 16 <= n)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(needle)));
+        if (mask)
+            return s + i + __builtin_ctz(mask);
+        i += 16;
+    }
+    return findByteScalar(s + i, c, n - i);
+}
+
+__attribute__((target("avx2")))
+static void toLowerAvx2(char *s, size_t n)
+{
+    const __m256i below = _mm256_set1_epi8('A' - 1);
+    const __m256i above = _mm256_set1_epi8('Z' + 1);
+    const __m256i bit = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(chunk, below), _mm256_cmpgt_epi8(above, chunk));
+        _mm256_storeu_si256((__m256i *)(s + i), _mm256_or_si256(chunk, _mm256_and_si256(upper, bit)));
+    }
+    if (i + 16 <= n)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm256_castsi256_si128(below)),
+                                      _mm_cmplt_epi8(chunk, _mm256_castsi256_si128(above)));
+        _mm_storeu_si128((__m128i *)(s + i), _mm_or_si128(chunk, _mm_and_si128(upper, _mm256_castsi256_si128(bit))));
+        i += 16;
+    }
+    toLowerScalar(s + i, n - i);
+}
+
+// AVX2 needs the CPU flag and the OS saving the YMM registers (OSXSAVE + XCR0)
+static bool cpuHasAvx2()
+{
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    if (!(ecx & (1u << 27)) || !(ecx & (1u << 28)))
+        return false;
+    unsigned xcr0Low, xcr0High;
+    __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    (void)xcr0High;
+    if ((xcr0Low & 6) != 6)
+        return false;
+    if (__get_cpuid_max(0, 0) < 7)
+        return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & (1u << 5)) != 0;
+}
+
+static bool cpuHasSse2()
+{
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (edx & (1u << 26)) != 0;
+}
+
+#endif // BYTE_SCAN_X86
+
+static const ByteScanKernels allKernels[] = {
+    { "scalar", findByteScalar, toLowerScalar },
+#ifdef BYTE_SCAN_X86
+    { "sse2", findByteSse2, toLowerSse2 },
+    { "avx2", findByteAvx2, toLowerAvx2 },
+#endif
+};
+
+static size_t detectKernels()
+{
+    size_t usable = 1;
+#ifdef BYTE_SCAN_X86
+    if (cpuHasSse2())
+    {
+        usable = 2;
+        if (cpuHasAvx2())
+            usable = 3;
+    }
+#endif
+    return usable;
+}
+
+// Runs during static initialisation, long before the workers start
+static const size_t usableKernels = detectKernels();
+static const ByteScanKernels &active = allKernels[usableKernels - 1];
+
+const char *ft_memchr(const char *s, int c, size_t n)
+{
+    return active.findByte(s, c, n);
+}
+
+void ft_strnlower(char *s, size_t n)
+{
+    active.toLower(s, n);
+}
+
+const ByteScanKernels *byteScanKernels(size_t &count)
+{
+    count = usableKernels;
+    return allKernels;
+}
@@ -0,0 +1,25 @@
+// Byte scanning kernels used by the request parser: finding a delimiter
+// ('\n', ':') and lowercasing header names. Each has a scalar version plus
+// SSE2 and AVX2 ones on x86; the fastest one the CPU supports is picked once
+// at startup (CPUID), before any worker thread exists.
+#ifndef BYTE_SCAN_HPP
+#define BYTE_SCAN_HPP
+
+#include <cstddef>
+
+// Same contract as memchr: first `c` in the n bytes at s, or NULL
+const char *ft_memchr(const char *s, int c, size_t n);
+// ASCII A-Z to a-z in place, other bytes untouched
+void ft_strnlower(char *s, size_t n);
+
+struct ByteScanKernels
+{
+    const char *name;
+    const char *(*findByte)(const char *s, int c, size_t n);
+    void (*toLower)(char *s, size_t n);
+};
+
+// Kernels usable on this CPU, slowest first; the last one is the active one
+const ByteScanKernels *byteScanKernels(size_t &count);
+
+#endif
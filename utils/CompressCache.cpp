@@ -0,0 +1,86 @@
+#include "CompressCache.hpp"
+#include "Gzip.hpp"
+#include <sstream>
+#include <stdint.h>
+
+CompressCache::CompressCache() : budget(0), used(0) {}
+
+CompressCache::~CompressCache()
+{
+    clear();
+}
+
+void CompressCache::configure(size_t maxBytes)
+{
+    clear();
+    budget = maxBytes;
+}
+
+void CompressCache::drop(Table::iterator it)
+{
+    Entry *entry = it->second;
+    lru.unlink(entry);
+    used -= entry->source.size() + entry->data.size();
+    table.erase(it);
+    delete entry;
+}
+
+// 64-bit FNV-1a: finds the entry, the stored body confirms it
+static uint64_t fnv1a(const std::string &data)
+{
+    const uint64_t prime = ((uint64_t)0x100 << 32) | 0x1b3;
+    uint64_t hash = ((uint64_t)0xcbf29ce4 << 32) | 0x84222325;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= prime;
+    }
+    return hash;
+}
+
+bool CompressCache::gzip(const std::string &body, int level, std::string &out)
+{
+    if (budget == 0)
+        return gzipString(body, level, out);
+
+    std::ostringstream key;
+    key << "gzip/" << level << "/" << std::hex << (unsigned long)fnv1a(body) << "/" << body.size();
+    Table::iterator it = table.find(key.str());
+    if (it != table.end())
+    {
+        if (it->second->source == body)
+        {
+            lru.touch(it->second);
+            out = it->second->data;
+            return true;
+        }
+        drop(it); // another body with the same hash and length: it takes the slot
+    }
+
+    if (!gzipString(body, level, out))
+        return false;
+    size_t cost = body.size() + out.size();
+    if (cost > budget)
+        return true;
+    while (used + cost > budget && lru.oldest())
+        drop(table.find(lru.oldest()->key));
+    Entry *entry = new Entry();
+    entry->key = key.str();
+    entry->source = body;
+    entry->data = out;
+    lru.pushNewest(entry);
+    table[entry->key] = entry;
+    used += cost;
+    return true;
+}
+
+void CompressCache::clear()
+{
+    while (!table.empty())
+        drop(table.begin());
+}
+
+size_t CompressCache::bytes() const
+{
+    return used;
+}
@@ -0,0 +1,51 @@
+#ifndef COMPRESS_CACHE_HPP
+#define COMPRESS_CACHE_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include "LruList.hpp"
+
+// gzip results of responses built in memory (directory listings, CGI output,
+// error pages), one cache per worker. Entries are found by a hash and the
+// length of the uncompressed body plus the level, and a hit is only used when
+// the stored body is the same byte for byte, so identical bodies are
+// compressed once whatever produced them. The least recently used entries go
+// when `budget` bytes (both bodies of each entry) would be exceeded.
+class CompressCache
+{
+public:
+    CompressCache();
+    ~CompressCache();
+
+    // budget 0 disables the cache: every body is compressed again
+    void configure(size_t budget);
+
+    // gzip of body at level into out; false on a zlib error
+    bool gzip(const std::string &body, int level, std::string &out);
+    void clear();
+    size_t bytes() const;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        std::string source; // uncompressed body: the hash alone could collide
+        std::string data;
+        Entry *newer; // LRU list
+        Entry *older;
+    };
+    typedef std::map<std::string, Entry *> Table;
+
+    Table table;
+    size_t budget;
+    size_t used;
+    LruList<Entry> lru;
+
+    void drop(Table::iterator it);
+
+    CompressCache(const CompressCache &);
+    CompressCache &operator=(const CompressCache &);
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "ContentCache.hpp"
+#include "../http/HttpUtils.hpp"
+#include <sstream>
+#include <unistd.h>
+
+CachedResponse *retainResponse(CachedResponse *response)
+{
+    response->refs++;
+    return response;
+}
+
+void releaseResponse(CachedResponse *response)
+{
+    if (--response->refs == 0)
+        delete response;
+}
+
+ContentCache::ContentCache() : budget(0), maxFile(0), used(0) {}
+
+ContentCache::~ContentCache()
+{
+    clear();
+}
+
+void ContentCache::configure(size_t maxBytes, size_t maxFileBytes)
+{
+    clear();
+    budget = maxBytes;
+    maxFile = maxFileBytes;
+}
+
+void ContentCache::drop(Table::iterator it)
+{
+    CachedResponse *response = it->second;
+    lru.unlink(response);
+    used -= response->headers.size() + response->body.size();
+    table.erase(it);
+    response->path.clear();
+    releaseResponse(response);
+}
+
+static bool readAll(int fd, std::string &body, size_t size)
+{
+    body.resize(size);
+    size_t done = 0;
+    while (done < size)
+    {
+        ssize_t n = pread(fd, &body[done], size - done, (off_t)done);
+        if (n <= 0)
+            return false; // error, or the file shrank while being read
+        done += n;
+    }
+    return true;
+}
+
+CachedResponse *ContentCache::get(const std::string &path, const OpenFile &file, const std::string &contentType)
+{
+    const struct stat &st = file.st;
+    if (budget == 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size > maxFile)
+        return 0;
+
+    Table::iterator it = table.find(path);
+    if (it != table.end())
+    {
+        CachedResponse *response = it->second;
+        if (sameFile(response->st, st))
+        {
+            lru.touch(response);
+            return retainResponse(response);
+        }
+        drop(it);
+    }
+
+    CachedResponse *response = new CachedResponse();
+    response->refs = 1;
+    response->newer = 0;
+    response->older = 0;
+    if (!readAll(file.fd, response->body, (size_t)st.st_size))
+    {
+        delete response;
+        return 0;
+    }
+    std::ostringstream headers;
+    headers << "Content-Type: " << contentType << "\r\n";
+    headers << "Content-Length: " << (long)st.st_size << "\r\n";
+    headers << "Accept-Ranges: bytes\r\n";
+    response->headers = headers.str();
+    response->etag = makeETag(st);
+    response->validators = "ETag: " + response->etag + "\r\nLast-Modified: " + httpDate(st.st_mtime) + "\r\n";
+    response->st = st;
+
+    size_t cost = response->headers.size() + response->body.size();
+    if (cost > budget)
+        return response; // served once, never kept
+    while (used + cost > budget && lru.oldest())
+        drop(table.find(lru.oldest()->path));
+    response->path = path;
+    table[path] = retainResponse(response);
+    lru.pushNewest(response);
+    used += cost;
+    return response;
+}
+
+void ContentCache::invalidate(const std::string &path)
+{
+    Table::iterator it = table.find(path);
+    if (it != table.end())
+        drop(it);
+    it = table.find(path + '\0');
+    if (it != table.end())
+        drop(it);
+}
+
+void ContentCache::clear()
+{
+    while (!table.empty())
+        drop(table.begin());
+}
+
+size_t ContentCache::bytes() const
+{
+    return used;
+}
@@ -0,0 +1,69 @@
+#ifndef CONTENT_CACHE_HPP
+#define CONTENT_CACHE_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include "FileCache.hpp"
+#include "LruList.hpp"
+
+// A small static file kept in memory with the start of its response head.
+// Send queues hold a reference while they send the body from here, so an
+// entry evicted or replaced meanwhile is freed only once they are done.
+struct CachedResponse
+{
+    std::string headers; // Content-Type, Content-Length and Accept-Ranges lines
+    std::string validators; // ETag and Last-Modified header lines
+    std::string etag;
+    std::string body;
+    int refs;
+
+    std::string path;  // key in the cache, empty once dropped from it
+    struct stat st;    // of the file the body was read from
+    CachedResponse *newer; // LRU list of the cache
+    CachedResponse *older;
+};
+
+CachedResponse *retainResponse(CachedResponse *response);
+void releaseResponse(CachedResponse *response);
+
+// Ready-made responses for small static files, one cache per worker.
+// Entries are checked against the OpenFile of every lookup, so they follow
+// the file cache: a file it sees changing (sameFile()) is read again.
+// The least recently used entries go when `budget` bytes would be exceeded.
+class ContentCache
+{
+public:
+    ContentCache();
+    ~ContentCache();
+
+    // budget 0 disables the cache
+    void configure(size_t budget, size_t maxFile);
+
+    // The response for `file` (opened from path) with a reference for the
+    // caller, read into the cache if needed. NULL when the file is not a
+    // regular file, is too large to be cached or cannot be read.
+    CachedResponse *get(const std::string &path, const OpenFile &file, const std::string &contentType);
+    // Forgets path and its precompressed variant key (path + '\0'), for files
+    // the server itself writes or deletes
+    void invalidate(const std::string &path);
+    void clear();
+    size_t bytes() const;
+
+private:
+    typedef std::map<std::string, CachedResponse *> Table;
+
+    Table table;
+    size_t budget;
+    size_t maxFile;
+    size_t used;
+    LruList<CachedResponse> lru;
+
+    void drop(Table::iterator it);
+
+    ContentCache(const ContentCache &);
+    ContentCache &operator=(const ContentCache &);
+};
+
+#endif
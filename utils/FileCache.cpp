@@ -0,0 +1,131 @@
+#include "FileCache.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+
+OpenFile *retainFile(OpenFile *file)
+{
+    file->refs++;
+    return file;
+}
+
+void releaseFile(OpenFile *file)
+{
+    if (--file->refs > 0)
+        return;
+    close(file->fd);
+    delete file;
+}
+
+FileCache::FileCache() : capacity(0), valid(0) {}
+
+FileCache::~FileCache()
+{
+    clear();
+}
+
+void FileCache::configure(size_t maxEntries, int validSeconds)
+{
+    clear();
+    capacity = maxEntries;
+    valid = validSeconds;
+}
+
+// Removes the entry from the table; sends still reading it keep it open
+void FileCache::drop(Table::iterator it)
+{
+    OpenFile *file = it->second;
+    lru.unlink(file);
+    table.erase(it);
+    file->path.clear();
+    releaseFile(file);
+}
+
+bool sameFile(const struct stat &a, const struct stat &b)
+{
+    return a.st_ino == b.st_ino && a.st_dev == b.st_dev && a.st_size == b.st_size &&
+           a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+OpenFile *FileCache::open(const std::string &path)
+{
+    time_t now = time(NULL);
+    Table::iterator it = table.find(path);
+    if (it != table.end())
+    {
+        OpenFile *file = it->second;
+        struct stat st;
+        if (now - file->checked < valid || (stat(path.c_str(), &st) == 0 && sameFile(st, file->st)))
+        {
+            if (now - file->checked >= valid)
+                file->checked = now;
+            lru.touch(file);
+            return retainFile(file);
+        }
+        drop(it);
+    }
+    return load(path, now);
+}
+
+OpenFile *FileCache::open(const std::string &path, const struct stat &current)
+{
+    time_t now = time(NULL);
+    Table::iterator it = table.find(path);
+    if (it != table.end())
+    {
+        OpenFile *file = it->second;
+        if (sameFile(current, file->st))
+        {
+            file->checked = now;
+            lru.touch(file);
+            return retainFile(file);
+        }
+        drop(it);
+    }
+    return load(path, now);
+}
+
+void FileCache::invalidate(const std::string &path)
+{
+    Table::iterator it = table.find(path);
+    if (it != table.end())
+        drop(it);
+}
+
+OpenFile *FileCache::load(const std::string &path, time_t now)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    OpenFile *file = new OpenFile();
+    if (fstat(fd, &file->st) < 0)
+    {
+        close(fd);
+        delete file;
+        return 0;
+    }
+    file->fd = fd;
+    file->refs = 1;
+    file->checked = now;
+    file->newer = 0;
+    file->older = 0;
+    if (capacity == 0)
+        return file;
+
+    if (table.size() >= capacity)
+        drop(table.find(lru.oldest()->path));
+    file->path = path;
+    table[path] = retainFile(file);
+    lru.pushNewest(file);
+    return file;
+}
+
+void FileCache::clear()
+{
+    while (!table.empty())
+        drop(table.begin());
+}
+
+size_t FileCache::size() const
+{
+    return table.size();
+}
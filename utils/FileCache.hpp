@@ -0,0 +1,74 @@
+#ifndef FILE_CACHE_HPP
+#define FILE_CACHE_HPP
+
+#include <cstddef>
+#include <ctime>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include "LruList.hpp"
+
+// An open descriptor and what fstat() said about it when it was opened.
+// The cache table and every send queue segment reading from it hold a
+// reference; the descriptor is closed when the last one goes.
+struct OpenFile
+{
+    int fd;
+    struct stat st;
+    int refs;
+    std::string contentType; // set by the first response sending it, empty until then
+
+    std::string path;  // key in the cache table, empty once dropped from it
+    time_t checked;    // last time the path was confirmed to name this file
+    OpenFile *newer;   // LRU list of the table
+    OpenFile *older;
+};
+
+// Takes one more reference on file
+OpenFile *retainFile(OpenFile *file);
+// Gives one back; the last one closes the descriptor
+void releaseFile(OpenFile *file);
+// Same inode, size and modification time (to the nanosecond)
+bool sameFile(const struct stat &a, const struct stat &b);
+
+// Open descriptors of static files, keyed by resolved path, one cache per worker.
+// A path looked up again within `valid` seconds of its last check is served
+// without a syscall; after that it is stat()ed once and reopened if it now names
+// another file or changed size or mtime. Past `capacity` entries the least
+// recently used one is dropped (its descriptor stays open while still being sent).
+class FileCache
+{
+public:
+    FileCache();
+    ~FileCache();
+
+    // capacity 0 disables caching: open() then opens a fresh descriptor every time
+    void configure(size_t capacity, int validSeconds);
+
+    // The file at path with a reference for the caller, or NULL (errno set)
+    OpenFile *open(const std::string &path);
+    // Same, for a path whose current metadata the caller already has (from the
+    // stat cache): the cached descriptor is used only when it matches, whatever
+    // its age, and reopened otherwise
+    OpenFile *open(const std::string &path, const struct stat &current);
+    // The server changed path itself: the next open() opens it again
+    void invalidate(const std::string &path);
+    void clear();
+    size_t size() const;
+
+private:
+    typedef std::map<std::string, OpenFile *> Table;
+
+    Table table;
+    size_t capacity;
+    int valid;
+    LruList<OpenFile> lru;
+
+    void drop(Table::iterator it);
+    OpenFile *load(const std::string &path, time_t now);
+
+    FileCache(const FileCache &);
+    FileCache &operator=(const FileCache &);
+};
+
+#endif
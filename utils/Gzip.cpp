@@ -0,0 +1,180 @@
+#include "Gzip.hpp"
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+// Files smaller than this gain nothing once the gzip header and trailer are added
+static const off_t MIN_SIZE = 256;
+
+bool isCompressibleType(const std::string &contentType)
+{
+    static const char *types[] = {"application/javascript", "application/json", "application/xml",
+                                  "application/xhtml+xml", "image/svg+xml", 0};
+    std::string type = contentType.substr(0, contentType.find(';'));
+    type = type.substr(0, type.find_last_not_of(" \t") + 1);
+    for (size_t i = 0; i < type.size(); ++i)
+        type[i] = std::tolower((unsigned char)type[i]);
+    if (type.compare(0, 5, "text/") == 0)
+        return true;
+    for (size_t i = 0; types[i]; ++i)
+    {
+        if (type == types[i])
+            return true;
+    }
+    return false;
+}
+
+bool gzipString(const std::string &data, int level, std::string &out)
+{
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+    // One call does it all: the output is sized for the worst case up front
+    out.resize(deflateBound(&zs, data.size()));
+    zs.next_in = (Bytef *)data.data();
+    zs.avail_in = (uInt)data.size();
+    zs.next_out = (Bytef *)&out[0];
+    zs.avail_out = (uInt)out.size();
+    int ret = deflate(&zs, Z_FINISH);
+    out.resize(out.size() - zs.avail_out);
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+
+static bool writeAll(int fd, const unsigned char *data, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t w = write(fd, data, n);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        data += w;
+        n -= w;
+    }
+    return true;
+}
+
+// Streams in through deflate into out; false on any read, write or zlib error
+static bool deflateFile(int in, int out, size_t &written)
+{
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    // 15 + 16: largest window with a gzip header instead of a zlib one
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    unsigned char input[65536];
+    unsigned char output[65536];
+    int ret = Z_OK;
+    written = 0;
+    while (ret != Z_STREAM_END)
+    {
+        ssize_t n = read(in, input, sizeof(input));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            break;
+        zs.next_in = input;
+        zs.avail_in = (uInt)n;
+        int flush = n == 0 ? Z_FINISH : Z_NO_FLUSH;
+        do
+        {
+            zs.next_out = output;
+            zs.avail_out = sizeof(output);
+            ret = deflate(&zs, flush);
+            size_t produced = sizeof(output) - zs.avail_out;
+            if (ret == Z_STREAM_ERROR || !writeAll(out, output, produced))
+            {
+                deflateEnd(&zs);
+                return false;
+            }
+            written += produced;
+        } while (zs.avail_out == 0);
+    }
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+
+bool gzipFile(const std::string &src, const std::string &dst)
+{
+    int in = open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        return false;
+    struct stat st;
+    std::string tmp = dst + ".tmp";
+    int out = -1;
+    if (fstat(in, &st) == 0)
+        out = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0)
+    {
+        close(in);
+        return false;
+    }
+
+    size_t written;
+    bool ok = deflateFile(in, out, written) && (off_t)written < st.st_size;
+    if (ok)
+    {
+        // Same mtime as the source: a later edit of the source makes it outdated
+        struct timespec times[2];
+        times[0] = st.st_atim;
+        times[1] = st.st_mtim;
+        ok = futimens(out, times) == 0;
+    }
+    close(in);
+    if (close(out) != 0)
+        ok = false;
+    if (ok && rename(tmp.c_str(), dst.c_str()) == 0)
+        return true;
+    unlink(tmp.c_str());
+    return false;
+}
+
+size_t precompressTree(const std::string &dir, const MimeTypes &mime)
+{
+    DIR *d = opendir(dir.c_str());
+    if (!d)
+        return 0;
+    size_t count = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL)
+    {
+        std::string name = ent->d_name;
+        if (name == "." || name == "..")
+            continue;
+        std::string path = dir + "/" + name;
+        struct stat st;
+        if (lstat(path.c_str(), &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+        {
+            count += precompressTree(path, mime);
+            continue;
+        }
+        if (!S_ISREG(st.st_mode) || st.st_size < MIN_SIZE)
+            continue;
+        // Judged by the type it is served with; unknown extensions (our own .tmp
+        // files among them) are left alone whatever default_type says
+        const std::string &type = mime.lookup(path);
+        if (&type == &mime.defaultType() || !isCompressibleType(type))
+            continue;
+
+        struct stat gz;
+        std::string gzPath = path + ".gz";
+        if (stat(gzPath.c_str(), &gz) == 0 && gz.st_mtime >= st.st_mtime)
+            continue;
+        if (gzipFile(path, gzPath))
+            count++;
+    }
+    closedir(d);
+    return count;
+}
@@ -0,0 +1,24 @@
+#ifndef GZIP_HPP
+#define GZIP_HPP
+
+#include <cstddef>
+#include <string>
+#include "../parsing_validation/MimeTypes.hpp"
+
+// Text formats worth compressing, judged by a Content-Type value (parameters ignored)
+bool isCompressibleType(const std::string &contentType);
+
+// gzip of data at level (1-9) into out; false on a zlib error
+bool gzipString(const std::string &data, int level, std::string &out);
+
+// Writes a gzip copy of src to dst, with src's modification time, through a
+// temporary file renamed into place. False, leaving nothing behind, when src
+// cannot be read or dst cannot be written or would not be smaller.
+bool gzipFile(const std::string &src, const std::string &dst);
+
+// Creates the missing or outdated `.gz` next to every file under dir whose
+// type in mime is compressible (recursively, symlinks not followed).
+// Returns how many were written.
+size_t precompressTree(const std::string &dir, const MimeTypes &mime);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef LRU_LIST_HPP
+#define LRU_LIST_HPP
+
+// Least recently used order of the entries of a per-worker cache. The list is
+// intrusive: T carries the `newer` and `older` pointers, nothing is allocated.
+template <typename T>
+class LruList
+{
+public:
+    LruList() : newestEntry(0), oldestEntry(0) {}
+
+    T *oldest() const
+    {
+        return oldestEntry;
+    }
+
+    void pushNewest(T *entry)
+    {
+        entry->newer = 0;
+        entry->older = newestEntry;
+        if (newestEntry)
+            newestEntry->newer = entry;
+        newestEntry = entry;
+        if (!oldestEntry)
+            oldestEntry = entry;
+    }
+
+    void unlink(T *entry)
+    {
+        if (entry->newer)
+            entry->newer->older = entry->older;
+        else
+            newestEntry = entry->older;
+        if (entry->older)
+            entry->older->newer = entry->newer;
+        else
+            oldestEntry = entry->newer;
+        entry->newer = 0;
+        entry->older = 0;
+    }
+
+    // A hit: entry becomes the last one to go
+    void touch(T *entry)
+    {
+        unlink(entry);
+        pushNewest(entry);
+    }
+
+private:
+    T *newestEntry;
+    T *oldestEntry;
+};
+
+#endif
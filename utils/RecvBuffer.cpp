@@ -0,0 +1,143 @@
+#include "RecvBuffer.hpp"
+#include <cstring>
+
+BufferPool::BufferPool() {}
+
+BufferPool::~BufferPool()
+{
+    for (size_t i = 0; i < freeBlocks.size(); ++i)
+        delete[] freeBlocks[i];
+}
+
+char *BufferPool::acquire()
+{
+    if (freeBlocks.empty())
+        return new char[BLOCK_BYTES];
+    char *block = freeBlocks.back();
+    freeBlocks.pop_back();
+    return block;
+}
+
+// Keeps a bounded reserve; past it, blocks go back to the allocator
+void BufferPool::release(char *block)
+{
+    if (freeBlocks.size() >= MAX_FREE)
+    {
+        delete[] block;
+        return;
+    }
+    freeBlocks.push_back(block);
+}
+
+RecvBuffer::RecvBuffer() : block(0), capacity(0), start(0), end(0), pooled(false) {}
+
+RecvBuffer::~RecvBuffer()
+{
+    delete[] block;
+}
+
+const char *RecvBuffer::data() const
+{
+    static const char none = '\0';
+    return block ? block + start : &none;
+}
+
+char *RecvBuffer::data()
+{
+    static char none = '\0';
+    return block ? block + start : &none;
+}
+
+size_t RecvBuffer::size() const
+{
+    return end - start;
+}
+
+bool RecvBuffer::empty() const
+{
+    return end == start;
+}
+
+char *RecvBuffer::prepare(BufferPool &pool, size_t want, size_t &room)
+{
+    if (!block)
+    {
+        block = pool.acquire();
+        capacity = BufferPool::BLOCK_BYTES;
+        pooled = true;
+        start = end = 0;
+    }
+    if (capacity - end < want && start > 0)
+    {
+        // Slide the unread bytes down: they are at most what did not fit in one parse
+        std::memmove(block, block + start, end - start);
+        end -= start;
+        start = 0;
+    }
+    if (capacity - end < want)
+    {
+        size_t grown = capacity * 2;
+        while (grown - end < want)
+            grown *= 2;
+        char *bigger = new char[grown];
+        std::memcpy(bigger, block, end);
+        if (pooled)
+            pool.release(block);
+        else
+            delete[] block;
+        block = bigger;
+        capacity = grown;
+        pooled = false;
+    }
+    room = capacity - end;
+    return block + end;
+}
+
+void RecvBuffer::commit(size_t n)
+{
+    end += n;
+}
+
+void RecvBuffer::append(BufferPool &pool, const char *bytes, size_t n)
+{
+    size_t room;
+    char *dst = prepare(pool, n, room);
+    std::memcpy(dst, bytes, n);
+    end += n;
+}
+
+void RecvBuffer::consume(size_t n)
+{
+    start += n;
+    if (start >= end)
+        start = end = 0;
+}
+
+void RecvBuffer::erase(size_t offset, size_t n)
+{
+    char *at = block + start + offset;
+    std::memmove(at, at + n, end - (start + offset + n));
+    end -= n;
+    if (start >= end)
+        start = end = 0;
+}
+
+void RecvBuffer::clear()
+{
+    start = end = 0;
+}
+
+// A private allocation is simply freed: the next client starts from a pool block again
+void RecvBuffer::release(BufferPool &pool)
+{
+    if (!block || !empty())
+        return;
+    if (pooled)
+        pool.release(block);
+    else
+        delete[] block;
+    block = 0;
+    capacity = 0;
+    start = end = 0;
+    pooled = false;
+}
@@ -0,0 +1,65 @@
+#ifndef RECV_BUFFER_HPP
+#define RECV_BUFFER_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Fixed-size blocks shared by the receive buffers of one worker (never across threads).
+// A connection only holds a block while it has unparsed bytes, so idle
+// keep-alive clients cost no buffer memory.
+class BufferPool
+{
+public:
+    enum { BLOCK_BYTES = 16384, MAX_FREE = 256 };
+
+    BufferPool();
+    ~BufferPool();
+
+    char *acquire();
+    void release(char *block);
+
+private:
+    std::vector<char *> freeBlocks;
+
+    BufferPool(const BufferPool &);
+    BufferPool &operator=(const BufferPool &);
+};
+
+// Bytes received from a client and not consumed yet, kept contiguous so the
+// request head can be sliced in place. The readable part is [start, end) of
+// one block: consuming from the front only moves `start`, and the leftover is
+// slid back to the beginning of the block when the tail runs out of room.
+// Heads or pipelines bigger than a pool block move to a private allocation.
+class RecvBuffer
+{
+public:
+    RecvBuffer();
+    ~RecvBuffer();
+
+    const char *data() const;
+    char *data();
+    size_t size() const;
+    bool empty() const;
+
+    // Free space at the end, at least `want` bytes: recv() writes straight into it
+    char *prepare(BufferPool &pool, size_t want, size_t &room);
+    void commit(size_t n);
+    void append(BufferPool &pool, const char *bytes, size_t n);
+
+    void consume(size_t n);             // drop n bytes from the front, O(1)
+    void erase(size_t offset, size_t n); // drop a range; what follows moves down
+    void clear();
+    void release(BufferPool &pool);     // hand the block back, only when empty
+
+private:
+    char *block;
+    size_t capacity;
+    size_t start;
+    size_t end;
+    bool pooled;     // block belongs to the pool (vs a private, larger allocation)
+
+    RecvBuffer(const RecvBuffer &);
+    RecvBuffer &operator=(const RecvBuffer &);
+};
+
+#endif
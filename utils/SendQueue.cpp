@@ -0,0 +1,178 @@
+#include "SendQueue.hpp"
+
+SendQueue::SendQueue() : bytes(0), pinned(0) {}
+
+SendQueue::~SendQueue()
+{
+    clear();
+}
+
+SendQueue::Segment &SendQueue::push()
+{
+    segments.push_back(Segment());
+    Segment &s = segments.back();
+    s.sent = 0;
+    s.file = 0;
+    s.shared = 0;
+    s.offset = 0;
+    s.length = 0;
+    return s;
+}
+
+void SendQueue::drop(Segment &s)
+{
+    if (s.file)
+        releaseFile(s.file);
+    if (s.shared)
+        releaseResponse(s.shared);
+    s.file = 0;
+    s.shared = 0;
+}
+
+size_t SendQueue::length(const Segment &s)
+{
+    if (s.file)
+        return s.length;
+    return s.shared ? s.shared->body.size() : s.data.size();
+}
+
+void SendQueue::append(const char *data, size_t n)
+{
+    if (n == 0)
+        return;
+    // Small responses go into the last segment when the kernel is not reading it
+    if (segments.size() > pinned && !segments.back().file && !segments.back().shared && segments.back().data.size() + n <= COALESCE)
+        segments.back().data.append(data, n);
+    else
+        push().data.assign(data, n);
+    bytes += n;
+}
+
+void SendQueue::append(const std::string &data)
+{
+    append(data.data(), data.size());
+}
+
+void SendQueue::adopt(std::string &data)
+{
+    if (data.size() < COALESCE)
+    {
+        append(data);
+        data.clear();
+        return;
+    }
+    bytes += data.size();
+    push().data.swap(data);
+}
+
+void SendQueue::appendFile(OpenFile *file, off_t offset, size_t length)
+{
+    if (length == 0)
+    {
+        releaseFile(file);
+        return;
+    }
+    Segment &s = push();
+    s.file = file;
+    s.offset = offset;
+    s.length = length;
+    bytes += length;
+}
+
+void SendQueue::appendBody(CachedResponse *response)
+{
+    // Small bodies are cheaper copied next to their headers than sent as a segment of their own
+    if (response->body.size() < COALESCE)
+    {
+        append(response->body);
+        releaseResponse(response);
+        return;
+    }
+    bytes += response->body.size();
+    push().shared = response;
+}
+
+bool SendQueue::empty() const
+{
+    return bytes == 0;
+}
+
+size_t SendQueue::size() const
+{
+    return bytes;
+}
+
+bool SendQueue::full() const
+{
+    return bytes >= HIGH_WATER;
+}
+
+size_t SendQueue::gather(struct iovec *iov, size_t max) const
+{
+    size_t n = 0;
+    for (std::deque<Segment>::const_iterator it = segments.begin(); it != segments.end() && n < max; ++it)
+    {
+        if (it->file)
+            break;
+        const std::string &src = it->shared ? it->shared->body : it->data;
+        iov[n].iov_base = const_cast<char *>(src.data()) + it->sent;
+        iov[n].iov_len = src.size() - it->sent;
+        n++;
+    }
+    return n;
+}
+
+bool SendQueue::frontFile(int &fd, off_t &offset, size_t &left) const
+{
+    if (segments.empty() || !segments.front().file)
+        return false;
+    const Segment &s = segments.front();
+    fd = s.file->fd;
+    offset = s.offset + (off_t)s.sent;
+    left = s.length - s.sent;
+    return true;
+}
+
+bool SendQueue::hasMore(size_t count) const
+{
+    return segments.size() > count;
+}
+
+void SendQueue::consume(size_t n)
+{
+    bytes -= n;
+    while (n > 0)
+    {
+        Segment &front = segments.front();
+        size_t left = length(front) - front.sent;
+        if (n < left)
+        {
+            front.sent += n;
+            return;
+        }
+        n -= left;
+        drop(front);
+        segments.pop_front();
+        if (pinned > 0)
+            pinned--;
+    }
+}
+
+void SendQueue::clear()
+{
+    for (std::deque<Segment>::iterator it = segments.begin(); it != segments.end(); ++it)
+        drop(*it);
+    segments.clear();
+    bytes = 0;
+    pinned = 0;
+}
+
+void SendQueue::pin(size_t count)
+{
+    pinned = count;
+}
+
+void SendQueue::unpin()
+{
+    pinned = 0;
+}
@@ -0,0 +1,85 @@
+#ifndef SEND_QUEUE_HPP
+#define SEND_QUEUE_HPP
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "FileCache.hpp"
+#include "ContentCache.hpp"
+
+// Bytes waiting to go out on one connection, as a queue of segments that a
+// single vectored send can pick up together (several pipelined responses,
+// headers and body of a file, ...). Sent bytes are dropped by advancing the
+// front segment, never by moving what is left.
+// A segment can also be a range of an open file, sent by the kernel straight
+// from the page cache (sendfile/splice) when it reaches the front, or the body
+// of a cached response, sent from the cache without being copied.
+class SendQueue
+{
+public:
+    enum
+    {
+        COALESCE = 16384,    // small appends share a segment up to this size
+        BATCH = 64,          // iovecs handed to one send call
+        HIGH_WATER = 262144  // queued bytes (files included) past which full() holds
+    };
+
+    SendQueue();
+    ~SendQueue();
+
+    void append(const char *data, size_t n);
+    void append(const std::string &data);
+    // Takes over the contents of `data` (left empty) without copying them
+    void adopt(std::string &data);
+    // Queues `length` bytes of file from `offset`, taking over one reference
+    // that is given back once they are sent or the queue is cleared
+    void appendFile(OpenFile *file, off_t offset, size_t length);
+    // Queues the body of a cached response, taking over one reference
+    void appendBody(CachedResponse *response);
+
+    bool empty() const;
+    size_t size() const;
+    // Enough is waiting: pipelined requests should not add to it until it drains
+    bool full() const;
+
+    // Fills up to `max` iovecs from the front of the queue, stopping at the
+    // first file segment; returns how many
+    size_t gather(struct iovec *iov, size_t max) const;
+    // True when the front segment is a file: where its unsent bytes start and how many are left
+    bool frontFile(int &fd, off_t &offset, size_t &left) const;
+    // More segments wait behind the first `count` ones
+    bool hasMore(size_t count) const;
+    void consume(size_t n);
+    void clear();
+
+    // The first `segments` segments were handed to the kernel (io_uring):
+    // their bytes must stay where they are until unpin()
+    void pin(size_t segments);
+    void unpin();
+
+private:
+    struct Segment
+    {
+        std::string data;
+        size_t sent;
+        OpenFile *file; // NULL for in-memory segments
+        CachedResponse *shared; // body sent from the cache instead of `data`
+        off_t offset;  // file segments: first byte of the range
+        size_t length; // file segments: size of the range
+    };
+
+    std::deque<Segment> segments;
+    size_t bytes;
+    size_t pinned;
+
+    Segment &push();
+    void drop(Segment &s);
+    static size_t length(const Segment &s);
+
+    SendQueue(const SendQueue &);
+    SendQueue &operator=(const SendQueue &);
+};
+
+#endif
@@ -0,0 +1,195 @@
+#include "StatCache.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Anything that can change what stat() returns for a directory entry
+static const uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                   IN_ATTRIB | IN_MODIFY | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+StatCache::StatCache() : inotifyFd(-1) {}
+
+StatCache::~StatCache()
+{
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+}
+
+bool StatCache::init(bool nonBlocking)
+{
+    inotifyFd = inotify_init1(IN_CLOEXEC | (nonBlocking ? IN_NONBLOCK : 0));
+    return inotifyFd >= 0;
+}
+
+int StatCache::fd() const
+{
+    return inotifyFd;
+}
+
+void StatCache::disable()
+{
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+    inotifyFd = -1;
+    table.clear();
+    dirs.clear();
+    watched.clear();
+}
+
+static std::string parentOf(const std::string &path)
+{
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos)
+        return ".";
+    if (slash == 0)
+        return "/";
+    return path.substr(0, slash);
+}
+
+bool StatCache::watch(const std::string &dir)
+{
+    if (watched.count(dir))
+        return true;
+    int wd = inotify_add_watch(inotifyFd, dir.c_str(), WATCH_MASK);
+    if (wd < 0)
+        return false;
+    // Two spellings of one directory ("www" and "www/") share the watch
+    dirs[wd].push_back(dir);
+    watched[dir] = wd;
+    return true;
+}
+
+int StatCache::stat(const std::string &path, struct stat &st)
+{
+    if (inotifyFd < 0)
+        return ::stat(path.c_str(), &st);
+
+    Table::iterator it = table.find(path);
+    if (it != table.end())
+    {
+        if (it->second.error)
+        {
+            errno = it->second.error;
+            return -1;
+        }
+        st = it->second.st;
+        return 0;
+    }
+
+    // Watch first: a change landing between the two calls is still reported
+    if (!watch(parentOf(path)))
+        return ::stat(path.c_str(), &st);
+    Entry entry;
+    entry.error = ::stat(path.c_str(), &entry.st) == 0 ? 0 : errno;
+    if (entry.error == 0)
+        st = entry.st;
+    // Other errors (EACCES, ...) may come from directories nobody watches
+    if (entry.error == 0 || entry.error == ENOENT || entry.error == ENOTDIR)
+    {
+        if (table.size() >= CAPACITY)
+            table.clear();
+        table[path] = entry;
+    }
+    errno = entry.error;
+    return entry.error ? -1 : 0;
+}
+
+bool StatCache::exists(const std::string &path)
+{
+    struct stat st;
+    return stat(path, st) == 0;
+}
+
+bool StatCache::isDirectory(const std::string &path)
+{
+    struct stat st;
+    return stat(path, st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Drops path and everything below it (a directory that went away takes its contents along)
+void StatCache::forgetTree(const std::string &path)
+{
+    table.erase(path);
+    std::string prefix = path;
+    while (prefix.size() > 1 && prefix[prefix.size() - 1] == '/')
+        prefix.erase(prefix.size() - 1);
+    table.erase(prefix);
+    prefix += '/';
+    Table::iterator it = table.lower_bound(prefix);
+    while (it != table.end() && it->first.compare(0, prefix.size(), prefix) == 0)
+        table.erase(it++);
+}
+
+void StatCache::forgetWatch(int wd)
+{
+    std::map<int, std::vector<std::string> >::iterator it = dirs.find(wd);
+    if (it == dirs.end())
+        return;
+    for (size_t i = 0; i < it->second.size(); ++i)
+    {
+        forgetTree(it->second[i]);
+        watched.erase(it->second[i]);
+    }
+    dirs.erase(it);
+}
+
+void StatCache::invalidate(const std::string &path)
+{
+    forgetTree(path);
+    table.erase(parentOf(path));
+}
+
+void StatCache::consume(const char *events, size_t length)
+{
+    size_t pos = 0;
+    while (pos + sizeof(struct inotify_event) <= length)
+    {
+        struct inotify_event ev;
+        std::memcpy(&ev, events + pos, sizeof(ev)); // the buffer may not be aligned for it
+        const char *name = events + pos + sizeof(ev);
+        pos += sizeof(ev) + ev.len;
+
+        if (ev.mask & IN_Q_OVERFLOW)
+        {
+            table.clear(); // events were lost: nothing can be trusted
+            continue;
+        }
+        if (ev.mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+        {
+            // A moved directory keeps its watch: drop it so its old name is watched afresh
+            if (!(ev.mask & IN_IGNORED))
+                inotify_rm_watch(inotifyFd, ev.wd);
+            forgetWatch(ev.wd);
+            continue;
+        }
+        std::map<int, std::vector<std::string> >::iterator it = dirs.find(ev.wd);
+        if (it == dirs.end() || ev.len == 0 || pos > length)
+            continue;
+        std::string child(name, strnlen(name, ev.len));
+        for (size_t i = 0; i < it->second.size(); ++i)
+            invalidate(it->second[i] + "/" + child);
+    }
+}
+
+void StatCache::drain()
+{
+    if (inotifyFd < 0)
+        return;
+    char buf[4096];
+    for (;;)
+    {
+        ssize_t n = read(inotifyFd, buf, sizeof(buf));
+        if (n > 0)
+            consume(buf, (size_t)n);
+        else if (n < 0 && errno == EINTR)
+            continue;
+        else
+            break;
+    }
+}
+
+void StatCache::clear()
+{
+    table.clear();
+}
@@ -0,0 +1,68 @@
+#ifndef STAT_CACHE_HPP
+#define STAT_CACHE_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+// What stat() said about paths under the served roots, one cache per worker.
+// Missing paths are cached too, so repeated 404s cost no syscall. An entry
+// stays valid until inotify reports a change in its directory: directories are
+// watched the first time one of their paths is looked up, and a path whose
+// directory cannot be watched is never cached.
+class StatCache
+{
+public:
+    enum
+    {
+        CAPACITY = 8192 // entries; the whole table is dropped when it fills up
+    };
+
+    StatCache();
+    ~StatCache();
+
+    // nonBlocking: reads of fd() return EAGAIN (poll engines) instead of
+    // waiting (io_uring). False when inotify is unavailable: every lookup is then a stat().
+    bool init(bool nonBlocking);
+    // inotify descriptor to read events from, -1 when disabled
+    int fd() const;
+    // Events can no longer be read: stop caching, every lookup is a stat() again
+    void disable();
+
+    // stat() through the cache: 0 with st filled, or -1 with errno set
+    int stat(const std::string &path, struct stat &st);
+    bool exists(const std::string &path);
+    bool isDirectory(const std::string &path);
+
+    // The server changed path itself: forget it without waiting for inotify
+    void invalidate(const std::string &path);
+    // Reads every pending event from fd() (non-blocking mode)
+    void drain();
+    // Applies events read from fd() by someone else (io_uring)
+    void consume(const char *events, size_t length);
+    void clear();
+
+private:
+    struct Entry
+    {
+        int error; // 0 when the path exists, errno of stat() otherwise
+        struct stat st;
+    };
+    typedef std::map<std::string, Entry> Table;
+
+    Table table;
+    std::map<int, std::vector<std::string> > dirs; // watch descriptor -> directory spellings
+    std::map<std::string, int> watched;            // directory spelling -> watch descriptor
+    int inotifyFd;
+
+    bool watch(const std::string &dir);
+    void forgetTree(const std::string &path);
+    void forgetWatch(int wd);
+
+    StatCache(const StatCache &);
+    StatCache &operator=(const StatCache &);
+};
+
+#endif
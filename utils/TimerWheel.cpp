@@ -0,0 +1,171 @@
+#include "TimerWheel.hpp"
+#include <time.h>
+
+TimerWheel::TimerWheel() : current(now()), count(0)
+{
+    for (int l = 0; l < LEVELS; ++l)
+        for (int s = 0; s < SLOTS; ++s)
+            slots[l][s].prev = slots[l][s].next = &slots[l][s];
+    expired.prev = expired.next = &expired;
+}
+
+uint64_t TimerWheel::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void TimerWheel::link(TimerNode &head, TimerNode &node)
+{
+    node.prev = head.prev;
+    node.next = &head;
+    head.prev->next = &node;
+    head.prev = &node;
+}
+
+void TimerWheel::unlink(TimerNode &node)
+{
+    node.prev->next = node.next;
+    node.next->prev = node.prev;
+    node.prev = node.next = 0;
+}
+
+// Picks the slot from how far away the deadline is: a level-L slot holds
+// every deadline that falls inside one 64^L-tick block.
+void TimerWheel::place(TimerNode &node)
+{
+    uint64_t expires = node.deadline;
+    if (expires <= current)
+    {
+        link(expired, node);
+        return;
+    }
+    uint64_t diff = expires - current;
+    int level = 0;
+    while (level < LEVELS - 1 && diff >= ((uint64_t)1 << (BITS * (level + 1))))
+        level++;
+    // Past the top level: park it at the far end, it is re-placed when that slot cascades
+    uint64_t span = (uint64_t)1 << (BITS * LEVELS);
+    if (diff >= span)
+        expires = current + span - 1;
+    link(slots[level][(expires >> (BITS * level)) & MASK], node);
+}
+
+void TimerWheel::schedule(TimerNode &node, uint64_t deadline)
+{
+    if (node.armed())
+        unlink(node);
+    else
+        count++;
+    node.deadline = deadline;
+    place(node);
+}
+
+void TimerWheel::cancel(TimerNode &node)
+{
+    if (!node.armed())
+        return;
+    unlink(node);
+    count--;
+}
+
+// Re-places every timer of the slot that just came up; they land in lower levels.
+void TimerWheel::cascade(int level)
+{
+    TimerNode &head = slots[level][(current >> (BITS * level)) & MASK];
+    while (head.next != &head)
+    {
+        TimerNode &node = *head.next;
+        unlink(node);
+        place(node);
+    }
+}
+
+void TimerWheel::advance(uint64_t now)
+{
+    while (current < now)
+    {
+        if (count == 0)
+        {
+            current = now;
+            break;
+        }
+        current++;
+        // Entering a new 64-tick block: pull the block's level-1 slot down, and keep
+        // going up while the higher levels also roll over
+        if ((current & MASK) == 0)
+        {
+            for (int l = 1; l < LEVELS; ++l)
+            {
+                cascade(l);
+                if ((current >> (BITS * l)) & MASK)
+                    break;
+            }
+        }
+        TimerNode &head = slots[0][current & MASK];
+        while (head.next != &head)
+        {
+            TimerNode &node = *head.next;
+            unlink(node);
+            link(expired, node);
+        }
+    }
+}
+
+TimerNode *TimerWheel::popExpired()
+{
+    if (expired.next == &expired)
+        return 0;
+    TimerNode *node = expired.next;
+    unlink(*node);
+    count--;
+    return node;
+}
+
+int TimerWheel::nextTimeout(uint64_t now, int maxMs) const
+{
+    if (expired.next != &expired)
+        return 0;
+    if (count == 0)
+        return maxMs;
+
+    uint64_t wake = 0;
+    // Level 0: the first non-empty slot is the exact next deadline
+    for (uint64_t t = current + 1; t <= current + SLOTS; ++t)
+    {
+        const TimerNode &head = slots[0][t & MASK];
+        if (head.next != &head)
+        {
+            wake = t;
+            break;
+        }
+    }
+    // Higher levels: wake up when the next non-empty slot cascades
+    for (int l = 1; l < LEVELS; ++l)
+    {
+        uint64_t block = current >> (BITS * l);
+        for (uint64_t b = block + 1; b <= block + SLOTS; ++b)
+        {
+            const TimerNode &head = slots[l][b & MASK];
+            if (head.next != &head)
+            {
+                uint64_t t = b << (BITS * l);
+                if (wake == 0 || t < wake)
+                    wake = t;
+                break;
+            }
+        }
+    }
+    if (wake == 0)
+        return maxMs;
+    if (wake <= now)
+        return 0;
+    uint64_t wait = wake - now;
+    return wait < (uint64_t)maxMs ? (int)wait : maxMs;
+}
+
+size_t TimerWheel::size() const
+{
+    return count;
+}
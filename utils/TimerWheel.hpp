@@ -0,0 +1,70 @@
+// Hierarchical timing wheel (the classic Linux kernel layout): 4 levels of
+// 64 slots with a 1 ms tick. Level 0 covers the next 64 ms one slot per tick,
+// each level above covers 64 times the span of the one below, and timers move
+// down a level ("cascade") when their slot comes up. Scheduling and cancelling
+// are O(1) through intrusive lists, so a timer can be re-armed on every I/O event.
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <stdint.h>
+#include <cstddef>
+
+// Embedded in the object that owns the deadline. Copies start out unarmed,
+// so owners can still be copied around before they are scheduled.
+struct TimerNode
+{
+    TimerNode *prev;
+    TimerNode *next;
+    uint64_t deadline; // in ticks (ms)
+    int kind;          // what the owner is (connection, CGI session, ...)
+    int id;            // owner lookup key, usually its fd
+
+    TimerNode() : prev(0), next(0), deadline(0), kind(0), id(-1) {}
+    TimerNode(const TimerNode &o) : prev(0), next(0), deadline(0), kind(o.kind), id(o.id) {}
+    TimerNode &operator=(const TimerNode &o)
+    {
+        // Never copy links: the destination keeps its own place in the wheel
+        kind = o.kind;
+        id = o.id;
+        return *this;
+    }
+    bool armed() const { return next != 0; }
+};
+
+class TimerWheel
+{
+public:
+    TimerWheel();
+
+    // Milliseconds on the monotonic clock
+    static uint64_t now();
+
+    void schedule(TimerNode &node, uint64_t deadline);
+    void cancel(TimerNode &node);
+
+    // Moves every timer due at `now` to the expired list; pop them with popExpired().
+    void advance(uint64_t now);
+    TimerNode *popExpired();
+
+    // Milliseconds the caller may sleep before advance() has work to do, capped at maxMs.
+    int nextTimeout(uint64_t now, int maxMs) const;
+    size_t size() const;
+
+private:
+    enum { LEVELS = 4, BITS = 6, SLOTS = 1 << BITS, MASK = SLOTS - 1 };
+
+    TimerNode slots[LEVELS][SLOTS]; // list heads (circular, sentinel)
+    TimerNode expired;
+    uint64_t current;               // last tick processed
+    size_t count;
+
+    void place(TimerNode &node);
+    void cascade(int level);
+    static void link(TimerNode &head, TimerNode &node);
+    static void unlink(TimerNode &node);
+
+    TimerWheel(const TimerWheel &);
+    TimerWheel &operator=(const TimerWheel &);
+};
+
+#endif
@@ -44,7 +44,10 @@ std::string generateDirectoryListing(const std::string &path, const std::string
             else
                 href = requestPath + "/" + name;
 
-            if (isDirectory(path + "/" + name))
+            // readdir already knows the type on most filesystems: stat only when it does not
+            bool dir = ent->d_type == DT_UNKNOWN || ent->d_type == DT_LNK ? isDirectory(path + "/" + name)
+                                                                           : ent->d_type == DT_DIR;
+            if (dir)
             {
                 href += "/";
                 displayName += "/";
@@ -75,6 +78,14 @@ int ft_isdigit(int c)
     return (c >= '0' && c <= '9');
 }
 
+size_t ft_strlen(const char *s)
+{
+    size_t i = 0;
+    while (s && s[i])
+        i++;
+    return i;
+}
+
 int ft_strncmp(const char *s1, const char *s2, size_t n)
 {
     size_t i = 0;
@@ -358,20 +369,12 @@ int ft_remove(const char *filename)
 // File I/O wrappers using allowed functions (open, write, close)
 int ft_file_open_temp(char *template_path)
 {
-    // Create a temporary file using mkstemp-like approach
-    // Since mkstemp is not in allowed list, we'll use open with O_CREAT | O_EXCL
-    // Template format: "/tmp/webserv.XXXXXX"
-    if (!template_path)
+    // Since mkstemp is not in allowed list, the caller picks a name that is
+    // unique for the request and we create (or truncate) it here.
+    if (!template_path || !*template_path)
         return -1;
 
-    // For simplicity, just create a temp file with fixed name
-    // In real scenario, you'd want unique names but we use a predictable path
-    const char *temp_name = "/tmp/webserv_tmp_XXXXXX";
-    ft_strcpy(template_path, temp_name);
-
-    // Try to create unique temp file using open with O_CREAT | O_EXCL | O_WRONLY
-    // This is a simplified version; real implementation would use mkstemp if available
-    int fd = open("/tmp/webserv_temp", O_CREAT | O_WRONLY | O_TRUNC, 0600);
+    int fd = open(template_path, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0600);
     return fd;
 }
 
@@ -13,6 +13,7 @@ std::string trim(const std::string &str);
 std::string removeComments(const std::string &line);
 int ft_tolower(int c);
 int ft_isdigit(int c);
+size_t ft_strlen(const char *s);
 int ft_strncmp(const char *s1, const char *s2, size_t n);
 std::istream &ft_getline(std::istream &is, std::string &str);
 std::istream &ft_getline(std::istream &is, std::string &str, char delim);